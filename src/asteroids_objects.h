@@ -2,6 +2,10 @@
  *
  * Objects created in Geometers's Sketchpad
  *
+ * These are in polar coordinates (radius, angle pairs), as modeled. The game
+ * doesn't use them directly: at build time, mkmodels converts them to the
+ * Cartesian tables in asteroids_models.h, so edit the shapes here and rebuild.
+ *
  * I'm releasing this code under the WTFPL. You can do whatever you like with
  * it, though I'd appreciate credit and thanks if you find it useful or fun.
  * See LICENSE.txt for details.
@@ -16,8 +20,8 @@
 //player ship
 // -PI/2 because I modeled the ship in the wrong position
 // now it faces the same direction it shoots
-const double ship_radius = 35.0;
-const double ship_p[] = {
+static const double ship_radius = 35.0;
+static const double ship_p[] = {
 	1.61495, -0.66940*PI - PI/2,	//lower left corner
 	1.00000,  0.50000*PI - PI/2,	//top
 	1.61495, -0.33060*PI - PI/2,	//lower right corner
@@ -26,16 +30,16 @@ const double ship_p[] = {
 };
 
 //flame added to player ship when the thruster is active
-const double flame_p[] = {
+static const double flame_p[] = {
 	1.03578, -0.41609*PI - PI/2,	//right
 	1.32782, -0.50000*PI - PI/2,	//tip
 	1.03578, -0.58391*PI - PI/2,	//left
 };
 
 //asteroids
-const double roid_radius[] = {80, 40, 20};
-const int roid_nsplit = sizeof(roid_radius)/sizeof(roid_radius[0]);
-const double roids_p[][24] = {
+static const double roid_radius[] = {80, 40, 20};
+static const int roid_nsplit = sizeof(roid_radius)/sizeof(roid_radius[0]);
+static const double roids_p[][24] = {
 	{
 		1.06765,  0.05172*PI,
 		0.52644,  0.27217*PI,
@@ -77,18 +81,18 @@ const double roids_p[][24] = {
 		1.00192, -0.00549*PI,
 	}
 };
-const int nroid_models = sizeof(roids_p)/sizeof(roids_p[0]);
+static const int nroid_models = sizeof(roids_p)/sizeof(roids_p[0]);
 
 //bullet
 // (written by hand because it's so simple)
-const double bullet_p[] = {
+static const double bullet_p[] = {
 	10.00000,  1.00000*PI,
 	10.00000,  0.00000*PI,
 };
 
-const double logo_radius = 450;
-const int logo_len[] = {5, 10, 4, 7, 9, 9, 3, 7, 10};
-const double logo_p[][20] = {
+static const double logo_radius = 450;
+static const int logo_len[] = {5, 10, 4, 7, 9, 9, 3, 7, 10};
+static const double logo_p[][20] = {
 	{		//A
 		0.80951, 0.95661*PI,
 		0.90894, -0.95888*PI,
@@ -190,6 +194,6 @@ const double logo_p[][20] = {
 		1.00254, -0.01917*PI,
 	}
 };
-const int logo_letters = sizeof(logo_p)/sizeof(logo_p[0]);
+static const int logo_letters = sizeof(logo_p)/sizeof(logo_p[0]);
 
 #endif
@@ -0,0 +1,472 @@
+/* Performance regression suite for the game's drawing
+ *
+ * Plays a few fixed scenes from the game through the same code it draws
+ * with (drawObj, drawPts, the rotation cache, drawText, then flip, which is
+ * where sendFrame renders each frame), on the null backend unless told
+ * otherwise, so no sound card is needed. For each scene it measures:
+ *    time per frame from the first draw call to the end of flip, in
+ *      microseconds: mean, median, 95th percentile and worst
+ *    samples per frame, and the refresh rate that works out to
+ *      (getRefreshRate)
+ *    memory allocations per frame (only where the Makefile can count them,
+ *      see COUNT_ALLOCS below)
+ *
+ * Each run's results are appended to a history file as one block, headed
+ * with the date and an optional label, so it's easy to see when something
+ * changed. Give a baseline (a history file from a known good build; its last
+ * run is used) and every scene is compared with it. Anything that got worse
+ * by more than the thresholds is marked, and the exit status is 1.
+ *
+ * The scenes are the same every run (fixed random seed), so samples and
+ * allocations should only change when the code does. Times depend on the
+ * machine, so only compare them with a baseline made on the same one.
+ *
+ * Usage: bench [options] [scene...]
+ *   -backend name: where to draw (default null, see gfxSelectBackend in gfx.h)
+ *   -frames N: frames to time in each scene (default 500)
+ *   -o file: append the results to this history file
+ *   -label text: tag the run in the history file (a version, say)
+ *   -baseline file: compare with the last run in this history file
+ *   -time PCT: median frame time may grow this much (default 10)
+ *   -samples PCT: samples per frame may grow this much (default 1)
+ *   -allocs N: allocations per frame may grow this much (default 0)
+ *   -simplify, -stabilize N, -interpolate, -lod Hz: as for the game
+ * Scenes (all of them if none are named):
+ *   title: the title screen, with the logo and 7 asteroids
+ *   roids4, roids16, roids32: the ship, bullets, score and that many asteroids
+ *   death: the ship blowing up among 4 asteroids
+ *
+ * I'm releasing this code under the WTFPL. You can do whatever you like with
+ * it, though I'd appreciate credit and thanks if you find it useful or fun.
+ * See LICENSE.txt for details.
+ *            -Joe McKenzie / Chupi
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+#include "gfx.h"
+#include "asteroids_models.h"
+#include "vlod.h"
+#include "vcache.h"
+#include "vfont.h"
+#include "draw.h"
+#include "settings.h"
+#include "prof.h"
+
+#define SEED 9001
+#define WARMUP 20	//frames drawn before timing starts, to fill the rotation cache and such
+#define MAX_RESULTS 64
+
+struct scene {
+	const char *name;
+	int roids;
+	int title;	//title screen: logo, asteroids bounce off it, no wrapping, no ship
+	int dead;	//ship in pieces
+};
+
+static const struct scene scenes[] = {
+	{"title", 7, 1, 0},
+	{"roids4", 4, 0, 0},
+	{"roids16", 16, 0, 0},
+	{"roids32", 32, 0, 0},
+	{"death", 4, 0, 1},
+};
+#define NSCENES ((int)(sizeof(scenes)/sizeof(scenes[0])))
+
+//one scene's results, as they're written to the history file
+struct result {
+	char name[32];
+	int frames;
+	double mean, median, p95, worst;	//microseconds
+	double samples, hz, allocs;	//per frame; allocs is -1 if they weren't counted
+};
+
+//anything moving: asteroids, bullets and fragments
+struct thing {
+	int id;
+	int model, split;
+	double angle, spin;
+	double posX, posY;
+	double spdX, spdY;
+	int age;
+};
+
+static struct vlod roidLod, logoLod;
+static int lodHz = LOD_HZ;
+static struct vcache roidCache;
+
+#ifdef COUNT_ALLOCS
+//The Makefile links bench with -Wl,--wrap for these where the linker can do
+//that, so every call our code makes goes through here first. SDL's own
+//allocations inside a shared library aren't counted.
+static volatile long allocs = 0;
+
+extern void *__real_malloc(size_t size);
+extern void *__real_calloc(size_t n, size_t size);
+extern void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size) {
+	__sync_fetch_and_add(&allocs, 1);
+	return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t n, size_t size) {
+	__sync_fetch_and_add(&allocs, 1);
+	return __real_calloc(n, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+	__sync_fetch_and_add(&allocs, 1);
+	return __real_realloc(ptr, size);
+}
+#endif
+
+static double randReal(double low, double high) {
+	return low + rand()/(((double)RAND_MAX + 1) / (high-low));
+}
+
+static int compareTimes(const void *a, const void *b) {
+	Uint64 x = *(const Uint64 *)a, y = *(const Uint64 *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static void wrap(double *x, double *y) {
+	if(*x > 1000) *x -= 1000;
+	else if(*x < 0) *x += 1000;
+	if(*y > 1000) *y -= 1000;
+	else if(*y < 0) *y += 1000;
+}
+
+static void newRoid(struct thing *a, int id, int split, const struct scene *sc) {
+	a->id = id;
+	a->model = rand()%nroid_models;
+	a->split = split;
+	a->angle = randReal(-PI, PI);
+	a->spin = randReal(-PI/64, PI/64);
+	a->spdX = randReal(-ROID_SPEED, ROID_SPEED);
+	a->spdY = randReal(-ROID_SPEED, ROID_SPEED);
+	a->posX = randReal(0, 1000);
+	a->posY = randReal(sc->title ? 300 : 0, 1000);
+}
+
+static void newFragment(struct thing *f, int id) {
+	f->id = id;
+	f->posX = 500 + randReal(-ship_radius, ship_radius);
+	f->posY = 500 + randReal(-ship_radius, ship_radius);
+	f->spdX = randReal(-4, 4);
+	f->spdY = randReal(-4, 4);
+	f->angle = randReal(-PI, PI);
+	f->spin = randReal(-PI/16, PI/16);
+	f->age = FRAGMENT_MAX_AGE;
+}
+
+static void runScene(const struct scene *sc, int frames, struct result *res) {
+	struct thing roids[MAX_ROIDS], bullets[MAX_BULLETS], fragments[MAX_FRAGMENTS];
+	double angle = -PI/2, samples = 0, hz = 0;
+	Uint64 *times, start, total = 0;
+#ifdef COUNT_ALLOCS
+	long allocSum = 0, allocStart;
+#endif
+	int i, k, v, f, id = 0, flame = 0;
+	const float *pts;
+
+	//samples per frame lately, for picking the detail to draw as the game does, but
+	//averaged from the start of the scene so it doesn't depend on the one before
+	struct beamStats beam;
+	double recent = 0, lodError;
+	long sent;
+
+	times = malloc(frames * sizeof(times[0]));
+	if(times == NULL) {
+		fprintf(stderr, "bench: out of memory\n");
+		exit(1);
+	}
+
+	//the same scene every time
+	srand(SEED);
+	for(i=0; i<sc->roids; i++)
+		//a fresh wave is all big ones, a crowded screen is mostly pieces
+		newRoid(&roids[i], ++id, sc->roids <= 4 ? 0 : i%roid_nsplit, sc);
+	for(i=0; i<MAX_BULLETS; i++) bullets[i].age = 0;
+	for(i=0; i<MAX_FRAGMENTS; i++) fragments[i].age = 0;
+	setWrap(!sc->title);
+
+	for(f=0; f<WARMUP+frames; f++) {
+		//move everything, as the game does
+		angle += PI/64;
+		for(i=0; i<sc->roids; i++) {
+			struct thing *a = &roids[i];
+
+			a->angle += a->spin;
+			if(a->angle > PI) a->angle -= 2*PI;
+			else if(a->angle < -PI) a->angle += 2*PI;
+			a->posX += a->spdX;
+			a->posY += a->spdY;
+			if(sc->title) {
+				if(a->posX > 1000) a->posX -= 1000;
+				else if(a->posX < 0) a->posX += 1000;
+				if(a->posY > 1000 || a->posY-roid_radius[a->split] < 250) a->spdY *= -1;
+			} else wrap(&a->posX, &a->posY);
+		}
+		for(i=0; i<MAX_BULLETS && !sc->title && !sc->dead; i++) {
+			struct thing *b = &bullets[i];
+
+			//keep all of them in the air, fired one after another
+			if(b->age-- <= 0 && f%4 == 0) {
+				b->id = ++id;
+				b->posX = b->posY = 500;
+				b->angle = angle;
+				b->spdX = BULLET_SPEED * cos(angle);
+				b->spdY = BULLET_SPEED * sin(angle);
+				b->age = MAX_BULLETS*4;
+			}
+			b->posX += b->spdX;
+			b->posY += b->spdY;
+			wrap(&b->posX, &b->posY);
+		}
+		for(i=0; i<MAX_FRAGMENTS && sc->dead; i++) {
+			struct thing *fr = &fragments[i];
+
+			//blow up again whenever the pieces are gone
+			if(fr->age-- <= 0) newFragment(fr, ++id);
+			fr->posX += fr->spdX;
+			fr->posY += fr->spdY;
+			wrap(&fr->posX, &fr->posY);
+			fr->angle += fr->spin;
+		}
+
+#ifdef COUNT_ALLOCS
+		allocStart = allocs;
+#endif
+		lodError = vlodAllowed(recent, FREQ, lodHz);
+		start = profNow();
+
+		//and draw it
+		if(sc->title) {
+			for(i=0; i<logo_letters; i++)
+				drawObj(&logoLod.models[vlodPick(&logoLod, i, logo_radius, lodError)], 0, logo_radius, 500, 150, 1.0);
+		} else if(!sc->dead) {
+			beginObject(0, 500, 500, angle);
+			drawObj(&ship_model, angle, ship_radius, 500, 500, 1.0);
+			flame = !flame;
+			if(flame) {
+				drawObj(&flame_model, angle, ship_radius, 500, 500, 1.0);
+				drawObj(&flame_model, angle, ship_radius, 500, 500, 1.0);
+			}
+			endObject();
+			for(i=0; i<MAX_BULLETS; i++) {
+				if(bullets[i].age <= 0) continue;
+				beginObject(bullets[i].id, bullets[i].posX, bullets[i].posY, bullets[i].angle);
+				drawObj(&bullet_model, bullets[i].angle, 1.0, bullets[i].posX, bullets[i].posY, 1.0);
+				endObject();
+			}
+		}
+		for(i=0; i<MAX_FRAGMENTS && sc->dead; i++) {
+			beginObject(fragments[i].id, fragments[i].posX, fragments[i].posY, fragments[i].angle);
+			drawObj(&bullet_model, fragments[i].angle, 2.0, fragments[i].posX, fragments[i].posY, 1.0);
+			endObject();
+		}
+		for(i=0; i<sc->roids; i++) {
+			struct thing *a = &roids[i];
+
+			beginObject(a->id, a->posX, a->posY, a->angle);
+			v = vlodPick(&roidLod, a->model, roid_radius[a->split], lodError);
+			pts = vcacheGet(&roidCache, v, a->split, a->angle);
+			if(pts != NULL)
+				drawPts(pts, roidLod.models[v].n, a->posX, a->posY, 0.8-0.1*a->split);
+			else
+				drawObj(&roidLod.models[v], a->angle, roid_radius[a->split], a->posX, a->posY, 0.8-0.1*a->split);
+			endObject();
+		}
+#ifndef NOHUD
+		if(!sc->title) {
+			drawText("0", HUD_SIZE, HUD_SIZE, HUD_SIZE, HUD_BRIGHT);
+			if(sc->dead) drawText("PRESS R", 500 - textWidth("PRESS R", HUD_SIZE)/2, 500 - HUD_SIZE/2, HUD_SIZE, HUD_BRIGHT);
+		}
+#endif
+		flip(1);
+
+		getBeamStats(&beam);
+		for(sent=0, k=0; k<BEAM_KINDS; k++) sent += beam.frame[k];
+		recent = f > 0 ? recent + (sent-recent)/16 : sent;
+
+		if(f < WARMUP) continue;
+		times[f-WARMUP] = profNow() - start;
+		total += times[f-WARMUP];
+#ifdef COUNT_ALLOCS
+		allocSum += allocs - allocStart;
+#endif
+		//backends that don't render samples have no refresh rate
+		if(getRefreshRate() > 0) {
+			hz += getRefreshRate();
+			samples += FREQ / getRefreshRate();
+		}
+	}
+
+	qsort(times, frames, sizeof(times[0]), compareTimes);
+	memset(res, 0, sizeof(struct result));
+	snprintf(res->name, sizeof(res->name), "%s", sc->name);
+	res->frames = frames;
+	res->mean = (double)total / frames;
+	res->median = times[frames/2];
+	res->p95 = times[frames*95/100];
+	res->worst = times[frames-1];
+	res->samples = samples / frames;
+	res->hz = hz / frames;
+#ifdef COUNT_ALLOCS
+	res->allocs = (double)allocSum / frames;
+#else
+	res->allocs = -1;
+#endif
+	free(times);
+}
+
+//the last run in a history file
+static int loadBaseline(const char *filename, struct result *base) {
+	FILE *f = fopen(filename, "r");
+	char line[256];
+	struct result r;
+	int n = 0, i;
+
+	if(f == NULL) {
+		perror(filename);
+		exit(1);
+	}
+	while(fgets(line, sizeof(line), f)) {
+		if(!strncmp(line, "# run", 5)) n = 0;	//only the last run counts
+		if(line[0] == '#') continue;
+		if(sscanf(line, "%31s %d %lf %lf %lf %lf %lf %lf %lf", r.name, &r.frames, &r.mean, &r.median, &r.p95, &r.worst, &r.samples, &r.hz, &r.allocs) != 9)
+			continue;
+		for(i=0; i<n && strcmp(base[i].name, r.name); i++);
+		if(i == MAX_RESULTS) continue;
+		base[i] = r;
+		if(i == n) n++;
+	}
+	fclose(f);
+	if(n == 0) {
+		fprintf(stderr, "%s has no results in it\n", filename);
+		exit(1);
+	}
+	return n;
+}
+
+//how much worse, as a percentage of the baseline
+static double change(double now, double was) {
+	return was > 0 ? 100*(now-was)/was : 0;
+}
+
+int main(int argc, char **argv) {
+	const char *backend = "null", *history = NULL, *label = "", *baseFile = NULL;
+	double timeLimit = 10, samplesLimit = 1, allocsLimit = 0;
+	int frames = 500, simplify = 0, stabilize = STABILIZE_SAMPLES, interpolate = 0;
+	struct result results[NSCENES], base[MAX_RESULTS];
+	const struct result *b;
+	const char *wanted[NSCENES];
+	int nwanted = 0, nresults = 0, nbase = 0, regressed = 0, worse;
+	char when[64];
+	time_t now;
+	FILE *f;
+	int i, j;
+
+	for(i=1; i<argc; i++) {
+		if(!strcmp(argv[i], "-backend") && i+1 < argc) backend = argv[++i];
+		else if(!strcmp(argv[i], "-frames") && i+1 < argc) frames = atoi(argv[++i]);
+		else if(!strcmp(argv[i], "-o") && i+1 < argc) history = argv[++i];
+		else if(!strcmp(argv[i], "-label") && i+1 < argc) label = argv[++i];
+		else if(!strcmp(argv[i], "-baseline") && i+1 < argc) baseFile = argv[++i];
+		else if(!strcmp(argv[i], "-time") && i+1 < argc) timeLimit = atof(argv[++i]);
+		else if(!strcmp(argv[i], "-samples") && i+1 < argc) samplesLimit = atof(argv[++i]);
+		else if(!strcmp(argv[i], "-allocs") && i+1 < argc) allocsLimit = atof(argv[++i]);
+		else if(!strcmp(argv[i], "-simplify")) simplify = 1;
+		else if(!strcmp(argv[i], "-stabilize") && i+1 < argc) stabilize = atoi(argv[++i]);
+		else if(!strcmp(argv[i], "-interpolate")) interpolate = 1;
+		else if(!strcmp(argv[i], "-lod") && i+1 < argc) lodHz = atoi(argv[++i]);
+		else {
+			for(j=0; j<NSCENES && strcmp(argv[i], scenes[j].name); j++);
+			if(j == NSCENES || nwanted == NSCENES) {
+				fprintf(stderr, "Unknown option %s\nUsage: %s [-backend name] [-frames N] [-o history.txt] [-label text] [-baseline history.txt] [-time PCT] [-samples PCT] [-allocs N] [-simplify] [-stabilize N] [-interpolate] [-lod Hz] [scene...]\nScenes:", argv[i], argv[0]);
+				for(j=0; j<NSCENES; j++) fprintf(stderr, " %s", scenes[j].name);
+				fprintf(stderr, "\n");
+				return 1;
+			}
+			wanted[nwanted++] = argv[i];
+		}
+	}
+	if(frames < 1) frames = 1;
+	if(baseFile != NULL) nbase = loadBaseline(baseFile, base);
+
+	//the null backend doesn't need SDL at all; the others start what they need
+	if(SDL_Init(0) != 0) {
+		fprintf(stderr, "Unable to initialize SDL: %s\n", SDL_GetError());
+		exit(1);
+	}
+	atexit(SDL_Quit);
+	gfxSelectBackend(backend);
+	gfxInit(FREQ, 1024);
+	setScale(0, 1000, 0, 1000, 100);
+	setSimplify(simplify);
+	setStabilize(stabilize);
+	setInterpolate(interpolate);
+	vlodInit(&roidLod, roid_models, nroid_models);
+	vlodInit(&logoLod, logo_models, logo_letters);
+	vcacheInit(&roidCache, roidLod.models, nroid_models*LOD_LEVELS, roid_radius, roid_nsplit, ROID_ANGLE_STEPS);
+
+	printf("%-8s %9s %9s %9s %9s %9s %7s %7s\n", "scene", "mean us", "median us", "95% us", "worst us", "samples", "Hz", "allocs");
+	for(i=0; i<NSCENES; i++) {
+		struct result *r = &results[nresults];
+
+		for(j=0; j<nwanted && strcmp(wanted[j], scenes[i].name); j++);
+		if(nwanted > 0 && j == nwanted) continue;
+		runScene(&scenes[i], frames, r);
+		nresults++;
+
+		printf("%-8s %9.1f %9.0f %9.0f %9.0f %9.1f %7.2f ", r->name, r->mean, r->median, r->p95, r->worst, r->samples, r->hz);
+		if(r->allocs >= 0) printf("%7.2f\n", r->allocs);
+		else printf("%7s\n", "-");
+
+		if(baseFile == NULL) continue;
+		for(b=base; b<base+nbase && strcmp(b->name, r->name); b++);
+		if(b == base+nbase) {
+			printf("%8s not in the baseline\n", "");
+			continue;
+		}
+		//times are compared by the median, which one slow frame doesn't move
+		worse = change(r->median, b->median) > timeLimit;
+		printf("%8s vs baseline: median %+.1f%%, samples %+.1f%%", "", change(r->median, b->median), change(r->samples, b->samples));
+		if(change(r->samples, b->samples) > samplesLimit) worse = 1;
+		if(r->allocs >= 0 && b->allocs >= 0) {
+			printf(", allocs %+.2f", r->allocs - b->allocs);
+			if(r->allocs - b->allocs > allocsLimit) worse = 1;
+		}
+		printf("%s\n", worse ? "  SLOWER" : "");
+		regressed |= worse;
+	}
+
+	vcacheFree(&roidCache);
+	vlodFree(&roidLod);
+	vlodFree(&logoLod);
+
+	if(history != NULL) {
+		f = fopen(history, "a");
+		if(f == NULL) {
+			perror(history);
+			exit(1);
+		}
+		now = time(NULL);
+		strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", localtime(&now));
+		fprintf(f, "# run %s backend %s %s\n", when, backend, label);
+		fprintf(f, "#scene frames mean_us median_us p95_us worst_us samples hz allocs\n");
+		for(i=0; i<nresults; i++) {
+			const struct result *r = &results[i];
+			fprintf(f, "%s %d %.1f %.0f %.0f %.0f %.1f %.2f %.2f\n", r->name, r->frames, r->mean, r->median, r->p95, r->worst, r->samples, r->hz, r->allocs);
+		}
+		fclose(f);
+	}
+
+	if(regressed) printf("\nSome scenes got worse than %s allows\n", baseFile);
+	return regressed;
+}
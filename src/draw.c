@@ -0,0 +1,48 @@
+/* Drawing the game's models (see draw.h)
+ *
+ * I'm releasing this code under the WTFPL. You can do whatever you like with
+ * it, though I'd appreciate credit and thanks if you find it useful or fun.
+ * See LICENSE.txt for details.
+ *            -Joe McKenzie / Chupi
+ */
+
+#include <math.h>
+#include "gfx.h"
+#include "draw.h"
+
+//draw a model rotated by angle, scaled by radius and centered on offX,offY
+void drawObj(const struct model *obj, double angle, double radius, double offX, double offY, double bright) {
+	double c, s, x, y;
+	int i;
+
+	if(obj->n < 2) return;	//need at least 2 points
+
+	//only one sin and cos per object, the points are already Cartesian
+	c = radius * cos(angle);
+	s = radius * sin(angle);
+
+	//move to first point
+	x = obj->xy[0]*c - obj->xy[1]*s + offX;
+	y = obj->xy[0]*s + obj->xy[1]*c + offY;
+	moveTo(x, y);
+	lineTo(x, y, bright/2);
+
+	//line to remaining points
+	for(i=1; i<obj->n; i++) {
+		x = obj->xy[2*i]*c - obj->xy[2*i+1]*s + offX;
+		y = obj->xy[2*i]*s + obj->xy[2*i+1]*c + offY;
+		lineTo(x, y, bright);
+	}
+}
+
+//draw points that are already rotated and scaled, moved to offX,offY
+void drawPts(const float *pts, int n, double offX, double offY, double bright) {
+	int i;
+
+	if(n < 2) return;
+
+	moveTo(pts[0] + offX, pts[1] + offY);
+	lineTo(pts[0] + offX, pts[1] + offY, bright/2);
+	for(i=1; i<n; i++)
+		lineTo(pts[2*i] + offX, pts[2*i+1] + offY, bright);
+}
@@ -0,0 +1,25 @@
+/* Drawing the game's models
+ *
+ * The game and the bench program (bench.c) both draw through these, so a
+ * benchmark times exactly what the game does every frame.
+ *
+ * I'm releasing this code under the WTFPL. You can do whatever you like with
+ * it, though I'd appreciate credit and thanks if you find it useful or fun.
+ * See LICENSE.txt for details.
+ *            -Joe McKenzie / Chupi
+ */
+
+#ifndef __DRAW_H__
+#define __DRAW_H__
+
+#include "asteroids_models.h"
+
+/* drawObj: draw a model rotated by angle, scaled by radius and centered on
+ *   offX,offY, using moveTo/lineTo with weight bright                        */
+extern void drawObj(const struct model *obj, double angle, double radius, double offX, double offY, double bright);
+
+/* drawPts: draw n x,y pairs that are already rotated and scaled (from
+ *   vcacheGet, say), moved to offX,offY                                      */
+extern void drawPts(const float *pts, int n, double offX, double offY, double bright);
+
+#endif
@@ -2,7 +2,17 @@
  *
  * Frames are drawn using moveTo/lineTo, which assemble lists of points (struct vlist). When
  * flip is called, sendFrame renders the vlist to an audio clip, which cb_fill_audio plays
- * back in a loop until a newer frame is sent.
+ * back in a loop until a newer frame is sent. With setMidFrameSwitch, the newer frame can
+ * take over at a stroke boundary partway through. A lazy scope (scope:lazy) skips the
+ * rendering in sendFrame; its frames are copies of the vlist, and cb_fill_audio renders
+ * them straight into SDL's buffer with a segment cursor that carries over between calls.
+ *
+ * The same renderer backs several backends (see gfx_backend.h), which only differ in where
+ * the rendered frames go: the sound card (scope), a shared memory ring for another process
+ * to play (shm, see gfx_shm.h), a raw PCM file (file), or nowhere at all (null).
+ *
+ * All of a renderer's state lives in its struct pcm, one per context, so any number can run
+ * at once on their own threads. Only one of them can own the sound card (soundOwner).
  *
  * I'm releasing this code under the WTFPL. You can do whatever you like with
  * it, though I'd appreciate credit and thanks if you find it useful or fun.
@@ -16,60 +26,301 @@
 #include <string.h>
 #include <math.h>
 #include "gfx.h"
+#include "gfx_backend.h"
+#include "gfx_shm.h"
+#include "prof.h"
 
 #define PI 3.14159265358979323846
 
+//brightness of the stabilizing border (see setStabilize)
+#define BORDER_WEIGHT 0.3
+
+//moving objects a frame can have (see setInterpolate); more than this stay put
+#define MAX_MOTIONS 255
+
+//buffer sizes GFX_BUFFER_AUTO tries, halving each time, and how long it tries each one
+#define CALIBRATE_MAX 1024
+#define CALIBRATE_MIN 64
+#define CALIBRATE_MS 500
+#define CALIBRATE_SETTLE 4	//callbacks ignored while the sound card gets going
+
+//heat map cells (see setHeatMap): HEAT_CELLS x HEAT_CELLS of them, each 1<<HEAT_SHIFT units square
+#define HEAT_SHIFT 10
+#define HEAT_CELLS (65536 >> HEAT_SHIFT)
+
+//frames getBeamStats's recent averages are over, roughly
+#define BEAM_RECENT 16
+
 //VList: x/y point list - sets of 3 Uint16's:
 // 1st is X coord, 0 is left, 64k is right
 // 2nd is Y coord, 0 is top, 64k is bottom
 // 3rd is weight in steps, 0 is dimmest; note that 44100 steps = 1 second to draw this line!!!
 //first point's weight is ignored as it's the start position
 //all remaining points' weights are the weight going TO that point
+//a cubic Bezier is 2 control points (flagged in ctrl, weight 0) then its end point, whose weight
+//is the steps for the whole curve
 struct vlist {
 	Uint16 *pts;
+	Uint8 *ctrl;	//nonzero for control points, which the beam doesn't go to
+	Uint8 *obj;	//motion each point moves with (see pcmSetMotion), 1 up; 0 for none
+	Uint8 *kind;	//what the beam is doing on the way to each point, BEAM_* (see getBeamStats)
 	int n;	//number of triplets in pts
+	int *breaks;	//indices of points reached by moveTo, where strokes start
+	int nbreaks;
 };
 
 //right channel is horizontal, left channel is vertical
+//a lazy frame (scope:lazy) has no samples, just a copy of the vlist's points, and the
+//audio callback renders it as it plays
 struct frame {
 	Sint16 *samples;
 	int n;	//number of left/right *pairs* of samples
+	int *switches;	//sample pair offsets where strokes start, ascending, starting with 0
+	int nswitches;
+
+	//lazy frames only
+	Uint16 *pts;
+	Uint8 *ctrl;
+	int *switchPts;	//the point each switch starts the stroke with
+	int mode;	//orientation when it was sent
+
+	//moving objects, which make a frame lazy: each point's motion, the motions, and how long
+	//(in sample pairs) they take to get from last tick to this one
+	Uint8 *obj;
+	double *motions;
+	int nmotions;
+	double tick;
+};
+
+//where the beam goes between two points: a cubic in forward differences, or a plain line
+struct segment {
+	int curved;
+	int steps, step;	//sample pairs in the segment, and how many are done
+	double f[2], d1[2], d2[2], d3[2];	//position and its differences, X then Y
 };
 
-//working vlist for moveTo/lineTo
-struct vlist work;
-Uint16 work_pts[(MAX_POINTS)*3];
+//a renderer, one per context using one of the backends here
+struct pcm {
+	//where rendered frames go
+	int output;
+	FILE *outFile;	//for OUT_FILE
+	struct shm_ring *ring;	//for OUT_SHM
+
+	//working vlist for moveTo/lineTo
+	struct vlist work;
+	Uint16 work_pts[(MAX_POINTS)*3];
+	Uint8 work_ctrl[MAX_POINTS];
+	Uint8 work_obj[MAX_POINTS];
+	Uint8 work_kind[MAX_POINTS];
+	int work_breaks[MAX_POINTS];
+
+	//currFrame is drawn repeatedly until a frame is waiting in the queue
+	//then the oldest waiting frame becomes currFrame (and currFrame is freed) when currFrame finishes drawing
+	//the queue is a ring of queueCount frames starting at queueHead; the audio lock protects it
+	struct frame currFrame;
+	struct frame queue[FRAME_QUEUE_MAX];
+	int queueHead, queueCount;
+	int queueDepth, queuePolicy;
+	long droppedFrames;
+
+	//where the audio callback is in currFrame (in bytes), and how much it's played since currFrame became current
+	int playPos, played;
+
+	//send frames as points for the audio callback to render as it plays? (scope:lazy)
+	//seg is the segment it's partway through, and segNext the point after it
+	int lazy;
+	struct segment seg;
+	int segNext;
 
-//currFrame is drawn repeatedly until nextFrame is non-null
-//then nextFrame becomes currFrame (and currFrame is freed) when currFrame finishes drawing
-struct frame currFrame, nextFrame;
+	//moving objects in the working vlist, each {cx, cy, dx, dy, da, aspect} in 0..65535 units,
+	//and the one being drawn (1 up, 0 for none); xf is how far the audio callback has moved them
+	//on this pass, as a 2x3 matrix each
+	double motions[MAX_MOTIONS][6];
+	int nmotions, motion;
+	double xf[MAX_MOTIONS][6];
 
-//"screen" dimensions
-double xmin=0, xmax=1000, ymin=0, ymax=1000, targetWeight=100;
+	//how long ticks (flip(1) to flip(1)) take, in ms, and when the last was
+	double tickMs;
+	Uint32 lastTick;
 
-//orientation
-int flipX=0, flipY=0, swapXY=0;
+	//switch to a waiting frame at the next stroke boundary instead of the end of the frame?
+	int midFrameSwitch;
 
-int g_freq;
-double g_refresh;
+	//simplify the vlist before rendering it? and points/samples before [0] and after [1], for the stats
+	int simplify;
+	long simpPoints[2], simpSamples[2];
 
-void cb_fill_audio(void *udata, Uint8 *stream, int len);
-void sendFrame(struct vlist *vl);
+	//border strokes for stabilizing the picture: one after every stabInterval samples of drawing (0 for none)
+	//stabSince counts samples since the last one, and stabInFrame is whether the working vlist has one yet
+	int stabInterval, stabSince, stabInFrame;
+	long stabBorders, stabSamples, totalSamples;
 
-void gfxInit(int freq, int buffer) {
+	//samples of each kind sent, and whether the points being added are a border's (see getBeamStats)
+	struct beamStats beam;
+	int bordering;
+
+	//samples spent in each cell of the screen, and where they go at the end (see setHeatMap)
+	long *heat;
+	char *heatFile;
+
+	//"screen" dimensions
+	double xmin, xmax, ymin, ymax, targetWeight;
+
+	//orientation (see setMode)
+	int mode;
+
+	int freq;
+	double refresh;
+};
+
+enum { OUT_SOUND, OUT_SHM, OUT_FILE, OUT_NULL };
+
+//there's only one sound card to go around
+static struct pcm *soundOwner = NULL;
+
+static void cb_fill_audio(void *udata, Uint8 *stream, int len);
+static void sendFrame(struct pcm *p, struct vlist *vl);
+static void addPoint(struct pcm *p, double x, double y, double color);
+static void scalePoint(struct pcm *p, double *x, double *y);
+static void border(struct pcm *p);
+
+//setup shared by all outputs
+static struct pcm *pcmInit(int freq, int output) {
+	struct pcm *p = calloc(1, sizeof(struct pcm));
+
+	if(p == NULL) {
+		fprintf(stderr, "gfx: out of memory\n");
+		exit(1);
+	}
+	if(freq <= 0 ) freq=44100;
+	p->freq = freq;
+	p->output = output;
+	p->xmax = 1000;
+	p->ymax = 1000;
+	p->targetWeight = 100;
+	p->queueDepth = 1;
+	p->queuePolicy = QUEUE_LATEST;
+
+	//setup working vlist for moveTo/lineTo
+	p->work.pts = p->work_pts;
+	p->work.ctrl = p->work_ctrl;
+	p->work.obj = p->work_obj;
+	p->work.kind = p->work_kind;
+	p->work.n = 0;
+	p->work.breaks = p->work_breaks;
+	p->work.nbreaks = 0;
+	return p;
+}
+
+//what the sound card did while calibrating, from the callback's side
+static struct {
+	long period;	//microseconds of sound each callback supplies
+	long calls, late;	//late: came more than half a period later than it should have
+	long worst;	//most microseconds any callback was late by
+	Uint64 last;
+} cal;
+
+static void cb_calibrate(void *udata, Uint8 *stream, int len) {
+	Uint64 now = profNow();
+	long lateBy;
+
+	memset(stream, 0, len);
+	if(cal.calls++ >= CALIBRATE_SETTLE) {
+		lateBy = (long)(now - cal.last) - cal.period;
+		if(lateBy > cal.worst) cal.worst = lateBy;
+		if(lateBy > cal.period/2) cal.late++;
+	}
+	cal.last = now;
+}
+
+//the smallest buffer the sound card keeps up with, trying each size in turn
+//until one doesn't (so the beam sits in the middle for a couple of seconds)
+static int calibrate(int freq) {
+	SDL_AudioSpec aspec;
+	int buffer, best = CALIBRATE_MAX;
+	long expected;
+
+	for(buffer = CALIBRATE_MAX; buffer >= CALIBRATE_MIN; buffer /= 2) {
+		memset(&cal, 0, sizeof(cal));
+		cal.period = (long)buffer * 1000000 / freq;
+		aspec.freq = freq;
+		aspec.format = AUDIO_S16SYS;
+		aspec.channels = 2;
+		aspec.samples = buffer;
+		aspec.callback = cb_calibrate;
+		aspec.userdata = NULL;
+		if(SDL_OpenAudio(&aspec, NULL) < 0) break;
+		SDL_PauseAudio(0);
+		SDL_Delay(CALIBRATE_MS);
+		SDL_CloseAudio();	//waits for the callback to finish, so cal is settled
+
+		expected = CALIBRATE_MS*1000L / cal.period;
+		fprintf(stderr, "Calibrating audio buffer: %d samples, %ld of %ld callbacks, %ld late, worst %.1f ms late\n",
+			buffer, cal.calls, expected, cal.late, cal.worst/1000.0);
+		if(cal.late > 0 || cal.calls < expected*9/10) break;
+		best = buffer;
+	}
+	return best;
+}
+
+//the buffer size calibrated for freq before, or 0
+//the file has a "freq buffer" line for each calibration, and the last one counts
+static int loadCalibration(int freq) {
+	FILE *f = fopen(GFX_CALIBRATE_FILE, "r");
+	int fileFreq, buffer, found = 0;
+
+	if(f == NULL) return 0;
+	while(fscanf(f, "%d %d", &fileFreq, &buffer) == 2)
+		if(fileFreq == freq && buffer > 0) found = buffer;
+	fclose(f);
+	return found;
+}
+
+static void saveCalibration(int freq, int buffer) {
+	FILE *f = fopen(GFX_CALIBRATE_FILE, "a");
+
+	if(f == NULL) {
+		perror(GFX_CALIBRATE_FILE);
+		return;	//it'll just calibrate again next time
+	}
+	fprintf(f, "%d %d\n", freq, buffer);
+	fclose(f);
+}
+
+//arg is "lazy" to render frames in the audio callback, or NULL
+static void *scopeInit(int freq, int buffer, const char *arg) {
 	SDL_AudioSpec aspec;
 	Sint16 *initSamps;
+	struct pcm *p;
 
-	if(freq <= 0 ) freq=44100;
-	g_freq = freq;
+	if(soundOwner != NULL) {
+		fprintf(stderr, "Only one scope can use the sound card. Use shm or file for the others.\n");
+		exit(1);
+	}
+	p = pcmInit(freq, OUT_SOUND);
+	if(arg != NULL) {
+		if(strcmp(arg, "lazy")) {
+			fprintf(stderr, "scope: unknown option %s (the only one is lazy)\n", arg);
+			exit(1);
+		}
+		p->lazy = 1;
+	}
+	if(buffer == GFX_BUFFER_AUTO) {
+		buffer = loadCalibration(p->freq);
+		if(buffer == 0) {
+			buffer = calibrate(p->freq);
+			saveCalibration(p->freq, buffer);
+			fprintf(stderr, "Audio buffer calibrated to %d samples, saved in %s\n", buffer, GFX_CALIBRATE_FILE);
+		} else fprintf(stderr, "Audio buffer: %d samples, as calibrated in %s\n", buffer, GFX_CALIBRATE_FILE);
+	}
 	if(buffer <= 0) buffer=1024;
 
-	aspec.freq = freq;
+	aspec.freq = p->freq;
 	aspec.format = AUDIO_S16SYS;	//accept "Sint16" samples
 	aspec.channels = 2;
 	aspec.samples = buffer;
 	aspec.callback = cb_fill_audio;
-	aspec.userdata = NULL;
+	aspec.userdata = p;
 
 	if(SDL_OpenAudio(&aspec, NULL) < 0) {
 		fprintf(stderr, "Couldn't open audio: %s\n", SDL_GetError());
@@ -77,193 +328,976 @@ void gfxInit(int freq, int buffer) {
 	}
 
 	//initialize frames
-	memset(&currFrame, 0, sizeof(struct frame));
-	memset(&nextFrame, 0, sizeof(struct frame));
-	initSamps = malloc(aspec.samples/4*aspec.channels*sizeof(initSamps[0]));
-	memset(initSamps, 0, aspec.samples/4*aspec.channels*sizeof(initSamps[0]));
-	currFrame.samples = initSamps;
-	currFrame.n = aspec.samples/4*aspec.channels;
-
-	//setup working vlist for moveTo/lineTo
-	work.pts = work_pts;
-	work.n = 0;
+	memset(&p->currFrame, 0, sizeof(struct frame));
+	memset(p->queue, 0, sizeof(p->queue));
+	p->currFrame.n = aspec.samples/4*aspec.channels;	//in pairs, so 2 samples each
+	initSamps = calloc(p->currFrame.n*2, sizeof(initSamps[0]));
+	p->currFrame.samples = initSamps;
 
+	soundOwner = p;
 	SDL_PauseAudio(0);	
+	return p;
 }
 
-//fill the buffer with loops of currFrame, switching to nextFrame if it's available
-void cb_fill_audio(void *udata, Uint8 *stream, int len) {
+//frames go to shared memory for another process to play, so no sound card
+//arg is the shared memory object name
+static void *shmInit(int freq, int buffer, const char *arg) {
+	struct pcm *p = pcmInit(freq, OUT_SHM);
+
+	p->ring = shmOpen(arg, p->freq);
+	return p;
+}
+
+//each frame is appended to a file once, as raw PCM in the same format the sound card gets
+//arg is the file name
+static void *fileInit(int freq, int buffer, const char *arg) {
+	struct pcm *p = pcmInit(freq, OUT_FILE);
+
+	if(arg == NULL) arg = "asteroids.raw";
+	p->outFile = fopen(arg, "wb");
+	if(p->outFile == NULL) {
+		perror(arg);
+		exit(1);
+	}
+	fprintf(stderr, "Writing frames to %s (raw signed 16-bit stereo, %d Hz)\n", arg, p->freq);
+	return p;
+}
+
+//render every frame as usual, then throw it away
+static void *nullInit(int freq, int buffer, const char *arg) {
+	return pcmInit(freq, OUT_NULL);
+}
+
+static void freeFrame(struct frame *f) {
+	free(f->samples);
+	free(f->switches);
+	free(f->pts);
+	free(f->ctrl);
+	free(f->switchPts);
+	free(f->obj);
+	free(f->motions);
+	memset(f, 0, sizeof(struct frame));
+}
+
+//write the heat map as a PGM image, the busiest cell white (see setHeatMap)
+static void writeHeatMap(struct pcm *p) {
+	long max = 0, total = 0;
+	FILE *f;
+	int i;
+
+	for(i=0; i<HEAT_CELLS*HEAT_CELLS; i++) {
+		total += p->heat[i];
+		if(p->heat[i] > max) max = p->heat[i];
+	}
+	f = fopen(p->heatFile, "w");
+	if(f == NULL) {
+		perror(p->heatFile);
+		return;
+	}
+	fprintf(f, "P2\n");
+	fprintf(f, "# beam time in each cell of the screen: %ld samples in all (%.1f s at %d Hz)\n", total, (double)total/p->freq, p->freq);
+	fprintf(f, "# the busiest cell had %ld samples (%.2f%%), and is %d here\n", max, total ? 100.0*max/total : 0.0, 65535);
+	fprintf(f, "%d %d\n65535\n", HEAT_CELLS, HEAT_CELLS);
+	for(i=0; i<HEAT_CELLS*HEAT_CELLS; i++)
+		fprintf(f, "%ld%c", max ? (long)(65535.0*p->heat[i]/max + 0.5) : 0, (i+1) % HEAT_CELLS ? ' ' : '\n');
+	fclose(f);
+	fprintf(stderr, "Wrote the beam's heat map to %s\n", p->heatFile);
+}
+
+static void pcmDestroy(void *st) {
+	struct pcm *p = st;
+	int i;
+
+	if(p->output == OUT_SOUND) {
+		//waits for the callback to finish
+		SDL_CloseAudio();
+		soundOwner = NULL;
+		freeFrame(&p->currFrame);
+		for(i=0; i<FRAME_QUEUE_MAX; i++) freeFrame(&p->queue[i]);
+	} else if(p->output == OUT_SHM) {
+		shmClose(p->ring);
+	} else if(p->output == OUT_FILE) {
+		fclose(p->outFile);
+	}
+	if(p->simpPoints[0] > 0)
+		fprintf(stderr, "Simplify: saved %ld of %ld points and %ld of %ld samples\n",
+			p->simpPoints[0]-p->simpPoints[1], p->simpPoints[0], p->simpSamples[0]-p->simpSamples[1], p->simpSamples[0]);
+	if(p->stabBorders > 0)
+		fprintf(stderr, "Stabilize: %ld borders used %ld of %ld samples (%.1f%%)\n",
+			p->stabBorders, p->stabSamples, p->totalSamples, 100.0*p->stabSamples/p->totalSamples);
+	if(p->heat != NULL) writeHeatMap(p);
+	free(p->heat);
+	free(p->heatFile);
+	free(p);
+}
+
+//make the oldest queued frame current
+//call with the audio lock held
+static void takeQueued(struct pcm *p) {
+	freeFrame(&p->currFrame);
+	memcpy(&p->currFrame, &p->queue[p->queueHead], sizeof(struct frame));
+	memset(&p->queue[p->queueHead], 0, sizeof(struct frame));
+	p->queueHead = (p->queueHead+1) % FRAME_QUEUE_MAX;
+	p->queueCount--;
+}
+
+//index of the first switch point in f at or after sample pair p (f->nswitches if none)
+static int switchIndex(const struct frame *f, int p) {
+	int lo = 0, hi = f->nswitches, mid;
+
+	while(lo < hi) {
+		mid = (lo+hi)/2;
+		if(f->switches[mid] < p) lo = mid+1;
+		else hi = mid;
+	}
+	return lo;
+}
+
+//first switch point in f at or after sample pair p, or f->n if there isn't one
+static int nextSwitch(const struct frame *f, int p) {
+	int i = switchIndex(f, p);
+
+	return i < f->nswitches ? f->switches[i] : f->n;
+}
+
+//switch point in f closest to sample pair p
+static int nearestSwitch(const struct frame *f, int p) {
+	int i = switchIndex(f, p);
+
+	if(f->nswitches == 0) return 0;
+	if(i == f->nswitches) return f->switches[i-1];
+	if(i > 0 && p - f->switches[i-1] < f->switches[i] - p) return f->switches[i-1];
+	return f->switches[i];
+}
+
+static void lazySeek(struct pcm *p);
+static void lazyRender(struct pcm *p, Sint16 *buf, int n);
+
+//fill the buffer with loops of currFrame, switching to the next queued frame if there is one
+static void cb_fill_audio(void *udata, Uint8 *stream, int len) {
 	//len is BYTES
-	static int pos = 0;	//position in currFrame (in bytes)
+	struct pcm *p = udata;
 	int left = len;	//bytes we still need to do
 	int done = 0;
 	int frameLeft;	//bytes left in currFrame
 	int toCopy;	//bytes for this memcpy
+	int sw;	//next switch point in currFrame, in bytes
+	PROF_BEGIN(tCallback);
+#ifdef PROFILE
+	static int named = 0;
+	if(!named) {
+		PROF_THREAD("audio callback");
+		named = 1;
+	}
+#endif
 
 	while(left > 0) {
-		frameLeft = currFrame.n*4 - pos;	// *4 because frame n values are in sample-pairs
+		frameLeft = p->currFrame.n*4 - p->playPos;	// *4 because frame n values are in sample-pairs
 		if(frameLeft < left) toCopy = frameLeft;
 		else toCopy = left;
 
-		if(toCopy > 0)
-			memcpy(stream+done, ((Uint8*)currFrame.samples)+pos, toCopy);
+		//if a frame is waiting, only go as far as the next stroke boundary
+		//(not for FIFO, which promises to show every frame in full). A frame
+		//we've only just switched to has to play something first, so look
+		//past the boundary it starts on, or we'd never get anywhere
+		sw = -1;
+		if(p->midFrameSwitch && p->queueCount > 0 && p->queuePolicy != QUEUE_FIFO) {
+			sw = nextSwitch(&p->currFrame, p->playPos/4 + (p->played == 0))*4;
+			if(sw - p->playPos < toCopy) toCopy = sw - p->playPos;
+		}
+
+		if(toCopy > 0) {
+			if(p->currFrame.samples) memcpy(stream+done, ((Uint8*)p->currFrame.samples)+p->playPos, toCopy);
+			else lazyRender(p, (Sint16 *)(stream+done), toCopy/4);
+		}
 
 		left -= toCopy;
 		done += toCopy;
-		pos += toCopy;
+		p->playPos += toCopy;
+		p->played += toCopy;
 		frameLeft -= toCopy;
 		if(frameLeft <= 0) {
 			if(frameLeft<0) fprintf(stderr, "frameLeft is %d !?!?!?\n", frameLeft);
 			//reached the end of this frame
-			pos = 0;
-			if(nextFrame.samples != NULL) {
+			p->playPos = 0;
+			if(p->queueCount > 0) {
 				//new frame available!
-				//replace currFrame with nextFrame
-				free(currFrame.samples);
-				memcpy(&currFrame, &nextFrame, sizeof(struct frame));
-				memset(&nextFrame, 0, sizeof(struct frame));
+				//replace currFrame with the oldest queued frame
+				takeQueued(p);
+				p->played = 0;
+			}
+			lazySeek(p);
+		} else if(p->playPos == sw && p->played > 0) {
+			//at a stroke boundary with a new frame waiting. Jump into the new
+			//frame at the stroke boundary the same fraction of the way through,
+			//so the rest of this pass draws the parts of the screen the old frame
+			//hadn't got to yet.
+			double frac = (double)p->playPos / (p->currFrame.n*4);
+			takeQueued(p);
+			p->playPos = nearestSwitch(&p->currFrame, (int)(frac*p->currFrame.n))*4;
+			p->played = 0;
+			lazySeek(p);
+		}
+	}
+	PROF_END(tCallback, "audio callback");
+}
+
+//throw away the oldest queued frame
+//call with the audio lock held
+static void dropOldest(struct pcm *p) {
+	freeFrame(&p->queue[p->queueHead]);
+	p->queueHead = (p->queueHead+1) % FRAME_QUEUE_MAX;
+	p->queueCount--;
+	p->droppedFrames++;
+}
+
+//number of L/R sample pairs vl renders to
+static int vlistSamples(const struct vlist *vl) {
+	int pt, n = 0;
+
+	for(pt = 1; pt < vl->n; pt++)
+		if(!vl->ctrl[pt]) n += vl->pts[3*pt+2]+1;
+	return n;
+}
+
+//write one beam position as a left/right sample pair, in orientation mode (see setMode)
+static void putSample(int mode, Sint16 *buf, double X, double Y) {
+	Sint16 iX, iY;
+
+	if(mode & 1) {
+		iX = (Sint16)(((int)X)-32768);
+	} else {
+		iX = (Sint16)(((int)(0x0ffff-(Uint16)X))-32768);
+	}
+	if(mode & 2) {
+		iY = (Sint16)(((int)(0x0ffff-(Uint16)Y))-32768);
+	} else {
+		iY = (Sint16)(((int)Y)-32768);
+	}
+	if(mode & 4) {
+		buf[0] = iX;
+		buf[1] = iY;
+	} else {
+		buf[0] = iY;
+		buf[1] = iX;
+	}
+}
+
+//set up s for the beam's path from point c[0..2]: a line to the next point, or if curved, the
+//cubic Bezier through the next two (control points) to the one after
+//each sample of a curve is one evenly spaced step in t, found by forward differencing, so the
+//curve costs a few additions per sample and is as finely divided as its weight allows
+static void segmentStart(struct segment *s, const Uint16 *c, int curved) {
+	double h, h2, h3, a, b;
+	int k;
+
+	s->step = 0;
+	s->curved = curved;
+	if(!s->curved) {
+		//evenly spaced from the point before up to, but not including, this one
+		s->steps = c[3+2]+1;
+		for(k=0; k<2; k++) {
+			s->f[k] = c[k];
+			s->d1[k] = (c[3+k]-c[k])/(double)s->steps;
+		}
+		return;
+	}
+
+	s->steps = c[3*3+2]+1;
+	h = 1.0/s->steps;
+	h2 = h*h;
+	h3 = h2*h;
+	for(k=0; k<2; k++) {
+		//B(t) = a t^3 + b t^2 + 3(P1-P0) t + P0
+		a = -c[k] + 3.0*c[3+k] - 3.0*c[6+k] + c[9+k];
+		b = 3.0*c[k] - 6.0*c[3+k] + 3.0*c[6+k];
+		s->f[k] = c[k];
+		s->d1[k] = a*h3 + b*h2 + 3.0*(c[3+k]-c[k])*h;
+		s->d2[k] = 6.0*a*h3 + 2.0*b*h2;
+		s->d3[k] = 6.0*a*h3;
+	}
+}
+
+//write the next n sample pairs of s to buf
+static void segmentRender(struct segment *s, int mode, Sint16 *buf, int n) {
+	double v[2];
+	int i, k;
+
+	s->step += n;
+	if(!s->curved) {
+		for(i=0; i<n; i++) {
+			putSample(mode, buf, s->f[0], s->f[1]);
+			buf += 2;
+			s->f[0] += s->d1[0];
+			s->f[1] += s->d1[1];
+		}
+		return;
+	}
+	for(i=0; i<n; i++) {
+		for(k=0; k<2; k++) {
+			//rounding can stray a hair past the edges, which the Uint16 casts don't like
+			v[k] = s->f[k] < 0 ? 0 : s->f[k] > 65535 ? 65535 : s->f[k];
+			s->f[k] += s->d1[k];
+			s->d1[k] += s->d2[k];
+			s->d2[k] += s->d3[k];
+		}
+		putSample(mode, buf, v[0], v[1]);
+		buf += 2;
+	}
+}
+
+//add where s puts the beam, sample by sample, to the heat map, following the same path as
+//segmentRender; s is a copy, so it can go on to be rendered
+static void segmentHeat(struct pcm *p, struct segment s) {
+	int v[2];
+	int i, k;
+
+	for(i=0; i<s.steps; i++) {
+		for(k=0; k<2; k++) {
+			v[k] = s.f[k] < 0 ? 0 : s.f[k] > 65535 ? 65535 : (int)s.f[k];
+			s.f[k] += s.d1[k];
+			if(s.curved) {
+				s.d1[k] += s.d2[k];
+				s.d2[k] += s.d3[k];
 			}
 		}
+		p->heat[(v[1] >> HEAT_SHIFT)*HEAT_CELLS + (v[0] >> HEAT_SHIFT)]++;
+	}
+}
+
+//lazy frames: point the segment cursor at currFrame's sample pair playPos/4, which is
+//always its start or one of its switch points
+//call with the audio lock held
+static void lazySeek(struct pcm *p) {
+	struct frame *f = &p->currFrame;
+	int pos = p->playPos/4;
+
+	double t, u, a, c, s, *m, *xf;
+	int i;
+
+	if(f->pts == NULL) return;
+	p->segNext = pos > 0 ? f->switchPts[switchIndex(f, pos)] : 1;
+	p->seg.step = p->seg.steps = 0;
+
+	//each pass moves the objects on to how far through the tick it is, then they wait there
+	if(f->nmotions == 0) return;
+	t = f->tick > 0 ? p->played/4 / f->tick : 1;
+	u = t < 1 ? 1-t : 0;	//how much of the way back to last tick
+	for(i=0; i<f->nmotions; i++) {
+		m = &f->motions[6*i];
+		xf = p->xf[i];
+		a = u*m[4];
+		c = cos(a);
+		s = sin(a);
+		//turn around the center, squashed to the screen's aspect ratio, then move it
+		xf[0] = c;
+		xf[1] = -s/m[5];
+		xf[2] = s*m[5];
+		xf[3] = c;
+		xf[4] = m[0] + u*m[2] - (xf[0]*m[0] + xf[1]*m[1]);
+		xf[5] = m[1] + u*m[3] - (xf[2]*m[0] + xf[3]*m[1]);
+	}
+}
+
+//lazy frames: copy n points of currFrame from first into out, moved where they are on this pass
+static const Uint16 *movePoints(struct pcm *p, int first, int n, Uint16 *out) {
+	const struct frame *f = &p->currFrame;
+	const Uint16 *in;
+	const double *xf;
+	double x, y;
+	int k;
+
+	for(k=0; k<n; k++) {
+		in = &f->pts[3*(first+k)];
+		out[3*k+2] = in[2];
+		if(f->obj[first+k] == 0) {
+			out[3*k+0] = in[0];
+			out[3*k+1] = in[1];
+			continue;
+		}
+		xf = p->xf[f->obj[first+k]-1];
+		x = xf[0]*in[0] + xf[1]*in[1] + xf[4];
+		y = xf[2]*in[0] + xf[3]*in[1] + xf[5];
+		out[3*k+0] = (Uint16)(x < 0 ? 0 : x > 65535 ? 65535 : x);
+		out[3*k+1] = (Uint16)(y < 0 ? 0 : y > 65535 ? 65535 : y);
+	}
+	return out;
+}
+
+//lazy frames: render the next n sample pairs of currFrame from the segment cursor
+//cb_fill_audio never asks for more than is left in the frame
+static void lazyRender(struct pcm *p, Sint16 *buf, int n) {
+	struct frame *f = &p->currFrame;
+	const Uint16 *c;
+	Uint16 moved[4*3];
+	int k, curved;
+
+	while(n > 0) {
+		if(p->seg.step == p->seg.steps) {
+			curved = f->ctrl[p->segNext];
+			c = &f->pts[3*(p->segNext-1)];
+			if(f->nmotions > 0) c = movePoints(p, p->segNext-1, curved ? 4 : 2, moved);
+			segmentStart(&p->seg, c, curved);
+			p->segNext += curved ? 3 : 1;
+		}
+		k = p->seg.steps - p->seg.step;
+		if(k > n) k = n;
+		segmentRender(&p->seg, f->mode, buf, k);
+		buf += k*2;
+		n -= k;
 	}
 }
 
 //submits vl is the next frame to draw, by rendering it to a frame of samples
-//if a nextFrame is already waiting, it is overwritten and freed
+//lazy frames just take a copy of the points, and the audio callback renders them
+//what happens if the queue is full depends on queuePolicy (see setFrameQueue)
 //**does NOT free vl or its point list**
-void sendFrame(struct vlist *vl) {
-	int i, pt, steps, pos=0;
-	double X, Y, t, nextX, nextY, dX, dY;
-	Sint16 iX, iY;
-	Sint16 *buf;
-	int bufsiz=0;	//buffer size in L/R pairs of samples
+static void sendFrame(struct pcm *p, struct vlist *vl) {
+	struct segment seg;
+	struct frame fr;
+	int pt, next, pos=0;	//pos is in L/R pairs of samples
+	Sint16 *buf = NULL;
+	int bufsiz;	//buffer size in L/R pairs of samples
+	int *switches = NULL, *switchPts = NULL, nswitches = 0, b = 0;
+	long kinds[BEAM_KINDS] = {0};
+	int k;
+	//moving objects are moved as the frame plays, so they need a lazy frame too
+	int lazy = p->output == OUT_SOUND && (p->lazy || p->nmotions > 0);
+	PROF_BEGIN(tRender);
 
-	//find buffer size
-	for(pt = 1; pt < vl->n; pt++)
-		bufsiz += vl->pts[3*pt+2]+1;
+	bufsiz = vlistSamples(vl);
 
 	//allocate buffer
-	buf = malloc(bufsiz * 4);	// *4 for 2 16-bit samples
-
-	for(pt = 1; pt < vl->n; pt++) {
-		X = vl->pts[3*(pt-1)+0];	//start at previous point
-		Y = vl->pts[3*(pt-1)+1];
-		nextX = vl->pts[3*pt+0];	//head toward current point
-		nextY = vl->pts[3*pt+1];
-		steps = vl->pts[3*pt+2]+1;
-		//fprintf(stderr, "\t%lf, %lf, %d\n", X, Y, steps);	//DEBUG: output points
-		dX = (nextX-X)/(double)steps;
-		dY = (nextY-Y)/(double)steps;
-		for(i=0; i<steps; i++) {
-			if(flipX) {
-				iX = (Sint16)(((int)X)-32768);
-			} else {
-				iX = (Sint16)(((int)(0x0ffff-(Uint16)X))-32768);
-			}
-			if(flipY) {
-				iY = (Sint16)(((int)(0x0ffff-(Uint16)Y))-32768);
-			} else {
-				iY = (Sint16)(((int)Y)-32768);
-			}
-			if(swapXY) {
-				buf[pos++] = iX;
-				buf[pos++] = iY;
-			} else {
-				buf[pos++] = iY;
-				buf[pos++] = iX;
-			}
-			X += dX;
-			Y += dY;
+	if(p->output == OUT_SHM) {
+		//render straight into the shared memory slot
+		buf = shmBeginFrame(p->ring, bufsiz);
+		if(buf == NULL) return;
+	} else if(!lazy) buf = malloc(bufsiz * 4);	// *4 for 2 16-bit samples
+
+	if(p->output == OUT_SOUND) {
+		//sample offsets where strokes start, where the audio callback may switch frames
+		//the start of the frame always counts
+		switches = malloc((vl->nbreaks+1) * sizeof(switches[0]));
+		if(lazy) {
+			switchPts = malloc((vl->nbreaks+1) * sizeof(switchPts[0]));
+			switchPts[0] = 1;
+		}
+		switches[nswitches++] = 0;
+	}
+
+	for(pt = 1; pt < vl->n; pt = next) {
+		//does a stroke start with the jump to this point?
+		while(b < vl->nbreaks && vl->breaks[b] < pt) b++;
+		if(switches != NULL && b < vl->nbreaks && vl->breaks[b] == pt && pos > switches[nswitches-1]) {
+			if(switchPts != NULL) switchPts[nswitches] = pt;
+			switches[nswitches++] = pos;
 		}
+
+		segmentStart(&seg, &vl->pts[3*(pt-1)], vl->ctrl[pt]);
+		next = pt + (vl->ctrl[pt] ? 3 : 1);
+		//fprintf(stderr, "\t%d: %d steps\n", pt, seg.steps);	//DEBUG: output points
+		kinds[vl->kind[next-1]] += seg.steps;
+		if(p->heat != NULL) segmentHeat(p, seg);
+		if(!lazy) segmentRender(&seg, p->mode, buf+pos*2, seg.steps);
+		pos += seg.steps;
 	}
 
+	PROF_END(tRender, "sendFrame render");
+
 	//DEBUG: sanity check
-	if(pos != bufsiz*2)
-		fprintf(stderr, "sendFrame: calculated %d samples needed, but used %d\n", bufsiz*2, pos);
+	if(pos != bufsiz)
+		fprintf(stderr, "sendFrame: calculated %d samples needed, but used %d\n", bufsiz*2, pos*2);
 
 	//fprintf(stderr, "Frame is %d samples, %lf Hz refresh\n", bufsiz, ((double)g_freq)/bufsiz);	//DEBUG: frame size and refresh rate
-	g_refresh = ((double)g_freq)/bufsiz;
+	p->refresh = ((double)p->freq)/bufsiz;
+	p->totalSamples += bufsiz;
+	for(k=0; k<BEAM_KINDS; k++) {
+		p->beam.frame[k] = kinds[k];
+		p->beam.recent[k] = p->beam.frames ? p->beam.recent[k] + (kinds[k]-p->beam.recent[k])/BEAM_RECENT : kinds[k];
+		p->beam.total[k] += kinds[k];
+	}
+	p->beam.frames++;
 
 	//DEBUG: write frame to raw audio file
 	//FILE *f = fopen("frame.raw", "wb");
 	//fwrite(buf, bufsiz*4, 1, f);
 	//fclose(f);
 
-	//save this to nextFrame
-	if(nextFrame.samples != NULL) {
+	if(p->output == OUT_SHM) {
+		shmEndFrame(p->ring);
+		return;
+	} else if(p->output == OUT_FILE) {
+		fwrite(buf, bufsiz*4, 1, p->outFile);
+		free(buf);
+		return;
+	} else if(p->output == OUT_NULL) {
+		free(buf);
+		return;
+	}
+
+	memset(&fr, 0, sizeof(fr));
+	fr.n = bufsiz;
+	fr.samples = buf;
+	fr.switches = switches;
+	fr.nswitches = nswitches;
+	if(lazy) {
+		fr.pts = malloc(vl->n*3 * sizeof(fr.pts[0]));
+		memcpy(fr.pts, vl->pts, vl->n*3 * sizeof(fr.pts[0]));
+		fr.ctrl = malloc(vl->n);
+		memcpy(fr.ctrl, vl->ctrl, vl->n);
+		fr.switchPts = switchPts;
+		fr.mode = p->mode;
+		if(p->nmotions > 0) {
+			fr.obj = malloc(vl->n);
+			memcpy(fr.obj, vl->obj, vl->n);
+			fr.motions = malloc(p->nmotions * sizeof(p->motions[0]));
+			memcpy(fr.motions, p->motions, p->nmotions * sizeof(p->motions[0]));
+			fr.nmotions = p->nmotions;
+			fr.tick = p->tickMs * p->freq / 1000;
+		}
+	}
+
+	//add it to the queue
+	SDL_LockAudio();
+	if(p->queuePolicy == QUEUE_FIFO) {
+		//wait for the audio callback to make room; every frame gets drawn
+		while(p->queueCount >= p->queueDepth) {
+			SDL_UnlockAudio();
+			SDL_Delay(1);
+			SDL_LockAudio();
+		}
+	} else if(p->queuePolicy == QUEUE_DROP_OLDEST) {
+		//make room by throwing away the oldest waiting frames
+		while(p->queueCount >= p->queueDepth) dropOldest(p);
+	} else {
+		//latest wins: anything still waiting is out of date now
 		//DEBUG: warn of dropped frame
-		//fprintf(stderr, "sendFrame: dropped frame of size %d because one of size %d didn't finish drawing in time; replacing with one of size %d\n", nextFrame.n, currFrame.n, bufsiz);
-		free(nextFrame.samples);
+		//if(queueCount > 0) fprintf(stderr, "sendFrame: dropped %d frames because the one of size %d didn't finish drawing in time\n", queueCount, currFrame.n);
+		while(p->queueCount > 0) dropOldest(p);
 	}
-	nextFrame.n = bufsiz;
-	nextFrame.samples = buf;
+	p->queue[(p->queueHead+p->queueCount) % FRAME_QUEUE_MAX] = fr;
+	p->queueCount++;
+	SDL_UnlockAudio();
 }
 
 //set screen size for moveTo/lineTo
 //xleft/xright are the X coordinate of the left/right edge of the screen
 //ytop/ybottom similarly
-void setScale(double xleft, double xright, double ytop, double ybottom, double weight) {
-	xmin = xleft;
-	xmax = xright;
-	ymin = ytop;
-	ymax = ybottom;
-	targetWeight = weight;
+static void pcmSetScale(void *st, double xleft, double xright, double ytop, double ybottom, double weight) {
+	struct pcm *p = st;
+
+	p->xmin = xleft;
+	p->xmax = xright;
+	p->ymin = ytop;
+	p->ymax = ybottom;
+	p->targetWeight = weight;
+}
+
+//start a new stroke at a point on the screen
+static void startStroke(struct pcm *p, double x, double y) {
+	//remember where strokes start, for switching frames mid-frame
+	if(p->work.n > 0 && p->work.n < MAX_POINTS) p->work.breaks[p->work.nbreaks++] = p->work.n;
+	addPoint(p, x, y, 0);
 }
 
 //move the cursor to a point on the screen
-void moveTo(double x, double y) {
-	lineTo(x, y, 0);
+//between strokes is where a border goes, if it's time for one
+static void pcmMoveTo(void *st, double x, double y) {
+	struct pcm *p = st;
+
+	if(p->stabInterval && p->stabSince >= p->stabInterval) border(p);
+	startStroke(p, x, y);
 }
 
 //draw a line to a point on the screen
 //color ranges from 0 (invisible) to 1 (bright) or more
-//if x or y are outside the screen, they simply get clamped to screen edges
-void lineTo(double x, double y, double color) {
-	//quit if vector list is full for this frame
-	if(work.n >= MAX_POINTS) return;
+//lines are clipped to the screen before they get here (see gfx_clip.h), so clamping
+//x or y to the screen edges only catches rounding
+static void pcmLineTo(void *st, double x, double y, double color) {
+	addPoint(st, x, y, color);
+}
+
+//draw a cubic Bezier curve from the current point, bending toward (x1,y1) and (x2,y2)
+//it's rendered straight to samples by sendFrame, so it only takes 3 points whatever its size
+static void pcmCubicTo(void *st, double x1, double y1, double x2, double y2, double x, double y, double color) {
+	struct pcm *p = st;
+	double len, chord;
+	Uint16 *pt;
+
+	//nowhere to start from, so just go to the end
+	if(p->work.n == 0) {
+		addPoint(p, x, y, 0);
+		return;
+	}
+	//quit if the whole curve won't fit
+	if(p->work.n+3 > MAX_POINTS) return;
 
-	//scale to 0..65535
-	if(xmin == xmax) x=32768;	//X axis flattened ==> go to middle
-	else x = ((x-xmin)/(xmax-xmin))*65535;
-	if(ymin == ymax) y=32768;	//Y axis flattened ==> go to middle
-	else y = ((y-ymin)/(ymax-ymin))*65535;
+	//clamped control points keep the whole curve on the screen, since it stays inside them
+	scalePoint(p, &x1, &y1);
+	scalePoint(p, &x2, &y2);
+	scalePoint(p, &x, &y);
 
-	//clamp to screen edges
-	if(x < 0) x=0;
-	else if(x > 65535) x=65535;
-	if(y < 0) y=0;
-	else if(y > 65535) y=65535;
+	//length is between the chord and the control polygon, so use the average
+	pt = &p->work.pts[(p->work.n-1)*3];
+	chord = hypot(x-pt[0], y-pt[1]);
+	len = hypot(x1-pt[0], y1-pt[1]) + hypot(x2-x1, y2-y1) + hypot(x-x2, y-y2);
+	len = (len+chord)/2/65535;
+	if(len < 0.00002) len = 5.0/100.0;	//dwell, like lineTo
+	color = color*len*p->targetWeight;
+	if(color < 1.0) color=1.0;
 
-	if(work.n > 0) {
+	pt += 3;
+	pt[0] = (Uint16)x1;
+	pt[1] = (Uint16)y1;
+	pt[2] = 0;
+	pt[3] = (Uint16)x2;
+	pt[4] = (Uint16)y2;
+	pt[5] = 0;
+	pt[6] = (Uint16)x;
+	pt[7] = (Uint16)y;
+	pt[8] = (Uint16)color;
+	p->work.ctrl[p->work.n] = 1;
+	p->work.ctrl[p->work.n+1] = 1;
+	p->work.ctrl[p->work.n+2] = 0;
+	memset(&p->work.obj[p->work.n], p->motion, 3);
+	memset(&p->work.kind[p->work.n], p->bordering ? BEAM_BORDER : BEAM_LINE, 3);
+	p->work.n += 3;
+	p->stabSince += pt[8]+1;
+}
+
+//scale a point to 0..65535 and clamp it to the screen edges
+static void scalePoint(struct pcm *p, double *x, double *y) {
+	if(p->xmin == p->xmax) *x=32768;	//X axis flattened ==> go to middle
+	else *x = ((*x-p->xmin)/(p->xmax-p->xmin))*65535;
+	if(p->ymin == p->ymax) *y=32768;	//Y axis flattened ==> go to middle
+	else *y = ((*y-p->ymin)/(p->ymax-p->ymin))*65535;
+
+	if(*x < 0) *x=0;
+	else if(*x > 65535) *x=65535;
+	if(*y < 0) *y=0;
+	else if(*y > 65535) *y=65535;
+}
+
+//append a point to the working vlist, shared by moveTo and lineTo
+static void addPoint(struct pcm *p, double x, double y, double color) {
+	int kind = p->bordering ? BEAM_BORDER : color == 0 ? BEAM_JUMP : BEAM_LINE;
+
+	//quit if vector list is full for this frame
+	if(p->work.n >= MAX_POINTS) return;
+
+	scalePoint(p, &x, &y);
+	if(p->work.n > 0) {
 		double xDist, yDist, lineLen, newColor;
 		//there's a previous point we're drawing a line from
 		//calculate steps from color and line length
-		xDist = work.pts[(work.n-1)*3+0] - x;
-		yDist = work.pts[(work.n-1)*3+1] - y;
+		xDist = p->work.pts[(p->work.n-1)*3+0] - x;
+		yDist = p->work.pts[(p->work.n-1)*3+1] - y;
 		lineLen = sqrt(xDist*xDist + yDist*yDist)/65535;
-		if(lineLen < 0.00002) lineLen = 5.0/100.0;	//allow "dwelling" on a point to draw a bright dot
+		if(lineLen < 0.00002) {
+			//allow "dwelling" on a point to draw a bright dot
+			lineLen = 5.0/100.0;
+			if(kind == BEAM_LINE) kind = BEAM_DWELL;
+		}
 		//65 is a good number of steps for a bright line all the way across the screen
-		color = color*lineLen*targetWeight;
+		color = color*lineLen*p->targetWeight;
 		if(color < 1.0) color=1.0;
+		p->stabSince += (Uint16)color+1;
 	} else color=0;	//first point must be a moveTo
 
 	//append to list
-	work.pts[work.n*3+0] = (Uint16)x;
-	work.pts[work.n*3+1] = (Uint16)y;
-	work.pts[work.n*3+2] = (Uint16)color;
-	work.n++;
+	p->work.pts[p->work.n*3+0] = (Uint16)x;
+	p->work.pts[p->work.n*3+1] = (Uint16)y;
+	p->work.pts[p->work.n*3+2] = (Uint16)color;
+	p->work.ctrl[p->work.n] = 0;
+	p->work.obj[p->work.n] = p->motion;
+	p->work.kind[p->work.n] = kind;
+	p->work.n++;
 }
 
-void flip(int clear) {
-	sendFrame(&work);
-	if(clear) work.n = 0;
+//a faint box around the edge of the screen
+//the sound card's outputs are AC coupled, so without one every so often the picture drifts and wobbles
+//with whatever's being drawn; it starts from the corner nearest the beam, so getting there costs little
+static void border(struct pcm *p) {
+	static const int corners[4][2] = {{0,0}, {1,0}, {1,1}, {0,1}};	//around the screen in order
+	double x[2] = {p->xmin, p->xmax}, y[2] = {p->ymin, p->ymax};
+	const Uint16 *last;
+	int first = 0, i, c, n0 = p->work.n, motion = p->motion;
+
+	if(p->work.n > 0) {
+		last = &p->work.pts[(p->work.n-1)*3];
+		for(first=0; first<3; first++)
+			if(corners[first][0] == (last[0] >= 32768) && corners[first][1] == (last[1] >= 32768)) break;
+	}
+	//the border doesn't move with whatever's being drawn, and the jump to it counts as part of it
+	p->motion = 0;
+	p->bordering = 1;
+	startStroke(p, x[corners[first][0]], y[corners[first][1]]);
+	for(i=1; i<=4; i++) {
+		c = (first+i) % 4;
+		addPoint(p, x[corners[c][0]], y[corners[c][1]], BORDER_WEIGHT);
+	}
+	p->motion = motion;
+	p->bordering = 0;
+
+	for(i = n0 > 0 ? n0 : 1; i < p->work.n; i++) p->stabSamples += p->work.pts[i*3+2]+1;
+	p->stabBorders++;
+	p->stabSince = 0;
+	p->stabInFrame = 1;
 }
 
-void setMode(int mode) {
-	flipX = mode&1;
-	flipY = mode&2;
-	swapXY = mode&4;
+//does the stroke of len points at b exactly retrace the one at a, and can their steps be added up?
+static int retraces(const struct vlist *vl, int a, int b, int len) {
+	int k;
+
+	for(k=0; k<len; k++) {
+		if(vl->pts[3*(a+k)+0] != vl->pts[3*(b+k)+0] || vl->pts[3*(a+k)+1] != vl->pts[3*(b+k)+1]) return 0;
+		if(vl->ctrl[a+k] != vl->ctrl[b+k] || vl->obj[a+k] != vl->obj[b+k] || vl->kind[a+k] != vl->kind[b+k]) return 0;
+		if(k > 0 && vl->pts[3*(a+k)+2] + vl->pts[3*(b+k)+2] + 1 > 65535) return 0;
+	}
+	return 1;
 }
 
-double getRefreshRate(void) {
-	return g_refresh;
+//fold each stroke that exactly retraces the one before it into that one, adding up the steps of
+//each segment. That's the same samples along the stroke, without the jump back to its start.
+static void foldRetraces(struct vlist *vl) {
+	int s, e, len, k, b = 0, o = 0, nb = 0;
+	int prev = 0, prevLen = 0;	//the last stroke kept
+
+	for(s = 0; s < vl->n; s = e) {
+		//a stroke runs from one moveTo to the next
+		e = b < vl->nbreaks ? vl->breaks[b++] : vl->n;
+		len = e - s;
+		if(len > 1 && len == prevLen && retraces(vl, prev, s, len)) {
+			for(k=1; k<len; k++)
+				if(!vl->ctrl[prev+k]) vl->pts[3*(prev+k)+2] += vl->pts[3*(s+k)+2]+1;
+			continue;
+		}
+		if(o > 0) vl->breaks[nb++] = o;
+		memmove(&vl->pts[3*o], &vl->pts[3*s], 3*len*sizeof(Uint16));
+		memmove(&vl->ctrl[o], &vl->ctrl[s], len);
+		memmove(&vl->obj[o], &vl->obj[s], len);
+		memmove(&vl->kind[o], &vl->kind[s], len);
+		prev = o;
+		prevLen = len;
+		o += len;
+	}
+	vl->n = o;
+	vl->nbreaks = nb;
+}
+
+//can line segments a-b and b-c be replaced by a-c with all their steps, without a visible change?
+static int canMerge(const Uint16 *a, const Uint16 *b, const Uint16 *c) {
+	long abx = b[0]-a[0], aby = b[1]-a[1], bcx = c[0]-b[0], bcy = c[1]-b[1];
+	double ab, bc;
+
+	if(b[2] + c[2] + 1 > 65535) return 0;
+	//one dwell after another
+	if(abx == 0 && aby == 0) return bcx == 0 && bcy == 0;
+	//a dwell at the end of a line is a bright dot
+	if(bcx == 0 && bcy == 0) return 0;
+	//carrying on the same way, with b within a unit of the line from a to c
+	if(abx*bcx + aby*bcy <= 0) return 0;
+	if(labs(abx*bcy - aby*bcx) > hypot(abx+bcx, aby+bcy)) return 0;
+	//at the same speed, to within a step, so the brightness doesn't change either
+	ab = hypot(abx, aby);
+	bc = hypot(bcx, bcy);
+	return fabs((b[2]+1)*bc - (c[2]+1)*ab) <= (ab > bc ? ab : bc);
+}
+
+//merge runs of dwells, and lines that carry straight on at the same speed
+//the merged segment gets the steps of both, so the samples stay the same
+static void mergeSegments(struct vlist *vl) {
+	Uint16 *a, *b, *c;
+	int i, bi = 0, o = 0, nb = 0, start = 0, isBreak;
+
+	for(i=0; i<vl->n; i++) {
+		isBreak = bi < vl->nbreaks && vl->breaks[bi] == i;
+		if(isBreak) bi++;
+		c = &vl->pts[3*i];
+
+		//both segments must be lines inside the same stroke, moving together, and the same kind
+		if(!isBreak && o-2 >= start && !vl->ctrl[i] && !vl->ctrl[o-1] && !vl->ctrl[o-2] &&
+			vl->obj[i] == vl->obj[o-1] && vl->obj[o-1] == vl->obj[o-2] && vl->kind[i] == vl->kind[o-1]) {
+			a = &vl->pts[3*(o-2)];
+			b = &vl->pts[3*(o-1)];
+			if(canMerge(a, b, c)) {
+				b[0] = c[0];
+				b[1] = c[1];
+				b[2] = b[2] + c[2] + 1;
+				continue;
+			}
+		}
+
+		if(isBreak) {
+			vl->breaks[nb++] = o;
+			start = o;
+		}
+		memmove(&vl->pts[3*o], c, 3*sizeof(Uint16));
+		vl->ctrl[o] = vl->ctrl[i];
+		vl->obj[o] = vl->obj[i];
+		vl->kind[o] = vl->kind[i];
+		o++;
+	}
+	vl->n = o;
+	vl->nbreaks = nb;
+}
+
+//optional pass before rendering: fewer points for the same picture
+static void simplify(struct pcm *p, struct vlist *vl) {
+	p->simpPoints[0] += vl->n;
+	p->simpSamples[0] += vlistSamples(vl);
+	foldRetraces(vl);
+	mergeSegments(vl);
+	p->simpPoints[1] += vl->n;
+	p->simpSamples[1] += vlistSamples(vl);
+}
+
+static void pcmFlip(void *st, int clear) {
+	struct pcm *p = st;
+	Uint32 now;
+
+	//how long a tick takes, for moving objects over (averaged, ignoring pauses)
+	if(clear) {
+		now = SDL_GetTicks();
+		if(p->lastTick && now - p->lastTick < 1000)
+			p->tickMs = p->tickMs > 0 ? (3*p->tickMs + (now - p->lastTick))/4 : now - p->lastTick;
+		p->lastTick = now;
+	}
+
+	//at least one border a frame, since the frame is all that gets drawn until the next one
+	if(p->stabInterval && !p->stabInFrame) border(p);
+	if(p->simplify) simplify(p, &p->work);
+	sendFrame(p, &p->work);
+	if(clear) {
+		p->work.n = 0;
+		p->work.nbreaks = 0;
+		p->stabSince = 0;
+		p->stabInFrame = 0;
+		p->nmotions = 0;
+		p->motion = 0;
+	}
+}
+
+static void pcmSetMode(void *st, int mode) {
+	struct pcm *p = st;
+
+	p->mode = mode;
+}
+
+static double pcmGetRefreshRate(void *st) {
+	return ((struct pcm *)st)->refresh;
+}
+
+static void scopeSetFrameQueue(void *st, int depth, int policy) {
+	struct pcm *p = st;
+
+	if(depth < 1) depth = 1;
+	if(depth > FRAME_QUEUE_MAX) depth = FRAME_QUEUE_MAX;
+
+	SDL_LockAudio();
+	p->queueDepth = depth;
+	p->queuePolicy = policy;
+	//if it got shorter, keep the newest frames
+	while(p->queueCount > p->queueDepth) dropOldest(p);
+	SDL_UnlockAudio();
+}
+
+static int scopeGetQueuedFrames(void *st) {
+	struct pcm *p = st;
+	int n;
+
+	//frames may be sent from another thread (see gfx_tee.c)
+	SDL_LockAudio();
+	n = p->queueCount;
+	SDL_UnlockAudio();
+	return n;
+}
+
+static long scopeGetDroppedFrames(void *st) {
+	struct pcm *p = st;
+	long n;
+
+	SDL_LockAudio();
+	n = p->droppedFrames;
+	SDL_UnlockAudio();
+	return n;
+}
+
+static void scopeSetMidFrameSwitch(void *st, int enable) {
+	((struct pcm *)st)->midFrameSwitch = enable;
+}
+
+static void pcmSetSimplify(void *st, int enable) {
+	((struct pcm *)st)->simplify = enable;
+}
+
+//motions are converted to the same 0..65535 units as the points, which is where they're applied
+static void pcmSetMotion(void *st, const double *m) {
+	struct pcm *p = st;
+	double *pm, sx, sy;
+
+	p->motion = 0;
+	if(m == NULL || p->xmin == p->xmax || p->ymin == p->ymax || p->nmotions == MAX_MOTIONS) return;
+	sx = 65535/(p->xmax-p->xmin);
+	sy = 65535/(p->ymax-p->ymin);
+	pm = p->motions[p->nmotions++];
+	pm[0] = (m[0]-p->xmin)*sx;
+	pm[1] = (m[1]-p->ymin)*sy;
+	pm[2] = m[2]*sx;
+	pm[3] = m[3]*sy;
+	pm[4] = m[4];
+	pm[5] = sy/sx;	//a turn is squashed by the screen's aspect ratio
+	p->motion = p->nmotions;
+}
+
+static void pcmSetStabilize(void *st, int interval) {
+	((struct pcm *)st)->stabInterval = interval > 0 ? interval : 0;
 }
+
+static void pcmGetBeamStats(void *st, struct beamStats *bs) {
+	*bs = ((struct pcm *)st)->beam;
+}
+
+static void pcmSetHeatMap(void *st, const char *filename) {
+	struct pcm *p = st;
+
+	free(p->heat);
+	free(p->heatFile);
+	p->heat = NULL;
+	p->heatFile = NULL;
+	if(filename == NULL) return;
+	p->heat = calloc(HEAT_CELLS*HEAT_CELLS, sizeof(p->heat[0]));
+	p->heatFile = strdup(filename);
+	if(p->heat == NULL || p->heatFile == NULL) {
+		fprintf(stderr, "gfx: out of memory\n");
+		exit(1);
+	}
+}
+
+const struct gfxBackend scopeBackend = {
+	"scope", "oscilloscope on the sound card",
+	scopeInit, pcmDestroy, pcmSetScale, pcmMoveTo, pcmLineTo, pcmCubicTo, pcmFlip, pcmSetMode,
+	scopeSetFrameQueue, scopeSetMidFrameSwitch, scopeGetQueuedFrames, scopeGetDroppedFrames, pcmGetRefreshRate, pcmSetSimplify, pcmSetStabilize, pcmSetMotion,
+	pcmGetBeamStats, pcmSetHeatMap
+};
+
+const struct gfxBackend shmBackend = {
+	"shm", "shared memory for another program to play (shm:/name)",
+	shmInit, pcmDestroy, pcmSetScale, pcmMoveTo, pcmLineTo, pcmCubicTo, pcmFlip, pcmSetMode,
+	NULL, NULL, NULL, NULL, pcmGetRefreshRate, pcmSetSimplify, pcmSetStabilize, pcmSetMotion,
+	pcmGetBeamStats, pcmSetHeatMap
+};
+
+const struct gfxBackend fileBackend = {
+	"file", "each frame once to a raw PCM file (file:name.raw)",
+	fileInit, pcmDestroy, pcmSetScale, pcmMoveTo, pcmLineTo, pcmCubicTo, pcmFlip, pcmSetMode,
+	NULL, NULL, NULL, NULL, pcmGetRefreshRate, pcmSetSimplify, pcmSetStabilize, pcmSetMotion,
+	pcmGetBeamStats, pcmSetHeatMap
+};
+
+const struct gfxBackend nullBackend = {
+	"null", "render frames and throw them away, for benchmarks",
+	nullInit, pcmDestroy, pcmSetScale, pcmMoveTo, pcmLineTo, pcmCubicTo, pcmFlip, pcmSetMode,
+	NULL, NULL, NULL, NULL, pcmGetRefreshRate, pcmSetSimplify, pcmSetStabilize, pcmSetMotion,
+	pcmGetBeamStats, pcmSetHeatMap
+};
@@ -10,20 +10,25 @@
  * separate sets of vectors. The farther the beam jumps, the dimmer the resulting
  * line, but it also makes a longer line.
  *
- * This system has 3 active frames.
+ * This system has 3 kinds of frames.
  *    Current frame: Currently being drawn on the scope.
- *    Waiting frame: Already been rendered to a PCM wave, will start drawing when
- *          the current frame finishes.
+ *    Waiting frames: Already been rendered to a PCM wave, will start drawing when
+ *          the current frame finishes. By default there's room for one.
  *    Work frame: Not yet rendered. Any draw operations work on this frame. Call
- *          flip to shift this to the waiting frame slot.
+ *          flip to add this to the waiting frames.
  *
  * If the current frame finishes drawing and there is no waiting frame, the
  * current frame is drawn again. If there is a waiting frame, the current frame
- * is deleted and the waiting one becomes current, leaving the waiting slot empty.
+ * is deleted and the oldest waiting one becomes current.
  *
  * The flip function (below) renders the work frame to a PCM wave and makes it
- * the waiting frame. If there's already a waiting frame, the old waiting frame
- * is dropped.
+ * a waiting frame. By default, if there's already a waiting frame, the old
+ * waiting frame is dropped. setFrameQueue changes that.
+ *
+ * Where the picture ends up is picked at runtime with gfxSelectBackend: the
+ * scope (the default), a window, shared memory, a raw PCM file, nowhere, or
+ * the scope and a window at the same time. Programs that need more than one
+ * picture at once can make several independent contexts (see gfxCreate).
  *
  * I'm releasing this code under the WTFPL. You can do whatever you like with
  * it, though I'd appreciate credit and thanks if you find it useful or fun.
@@ -34,15 +39,40 @@
 #ifndef __GFX_H__
 #define __GFX_H__
 
+#include <stdio.h>
 #include "SDL/SDL.h"
 #include "SDL/SDL_audio.h"
 
-/* Maximum number of moveTo/lineTo calls on screen at once. If this is exceeded,
- * all further calls to moveTo or lineTo will be ignored. The image will likely
+/* Maximum number of moveTo/lineTo calls on screen at once, where a curve counts
+ * as 3 for each quarter turn or Bezier. If this is exceeded, all further calls
+ * to draw will be ignored. The image will likely
  * become insanely flickery long before this. If you change this, you'll need to
  * recompile gfx.c.                                                           */
 #define MAX_POINTS 4096
 
+/* gfxSelectBackend: choose where to draw. Must be called before gfxInit; if
+ *   it isn't, the default backend (normally "scope") is used.
+ *   name: one of
+ *     scope: oscilloscope on the sound card, as described above.
+ *       "scope:lazy" sends frames as points instead of samples, and renders
+ *       them in the audio callback as they play. flip then costs time in
+ *       the number of points rather than samples, and hardly any memory.
+ *     window: draw in an SDL window, for debugging without a scope
+ *     shm: render frames and publish them in shared memory for another
+ *       program to play (see gfx_shm.h). "shm:/name" picks the object name.
+ *     file: render frames and append each one, once, to a raw PCM file.
+ *       "file:name.raw" picks the file, asteroids.raw by default.
+ *     null: render frames and throw them away. Does all the work of the
+ *       scope backend except the sound card, for timing the renderer.
+ *     tee: draw on two backends at once, each on its own thread, so the
+ *       window can't slow down the scope. "tee:scope+window" is the default;
+ *       "tee:a+b" picks any other two.
+ *   An unknown name prints the list of backends and exits.                  */
+extern void gfxSelectBackend(const char *name);
+
+/* gfxListBackends: print the backend names and what they do, one per line   */
+extern void gfxListBackends(FILE *f);
+
 /* gfxInit: initialize stuff and start SDL audio playing
  *   freq: audio sample frequency to use
  *   The requested frequency must be supported by your sound card.
@@ -61,8 +91,18 @@
  *   the program exits.
  *
  *   buffer: size of audio buffer in samples
- *     If zero or negative, a default value of 1024 is used.
+ *     It's also how far behind flip the beam can be, so smaller is snappier,
+ *     as long as the sound card keeps up. If zero or negative, a default value
+ *     of 1024 is used.
+ *     GFX_BUFFER_AUTO finds the smallest size that keeps up on this machine.
+ *     The scope tries sizes from 1024 down, about half a second each, for as
+ *     long as every callback comes on time. The size it picks is saved in
+ *     GFX_CALIBRATE_FILE in the current directory, per frequency, and used
+ *     from then on without trying again. Delete the file to calibrate again.
+ *     The other backends don't use a sound card, so they take no time over it.
  * */
+#define GFX_BUFFER_AUTO -1
+#define GFX_CALIBRATE_FILE "asteroids-audio.cfg"
 extern void gfxInit(int freq, int buffer);
 
 
@@ -70,6 +110,8 @@ extern void gfxInit(int freq, int buffer);
  *   The first 4 variables are self-explanitory.
  *   Note that if, say, xleft > xright, the X axis is inverted. This allows you
  *   to orient either axis either way.
+ *   Anything drawn outside these edges is clipped off, and costs nothing if
+ *   it's entirely off the screen.
  *
  *   weight: scale factor for weights for lineTo. This is a number of audio
  *     samples that will be spent on a lineTo call whose weight is 1.0. Too
@@ -81,8 +123,7 @@ extern void setScale(double xleft, double xright, double ytop, double ybottom, d
 
 /* moveTo: move as fast as possible to the specified point
  *   Note that the beam can't be turned off, so some line will still be visible.
- *   The farther you move at once, the dimmer the line.
- *   Many moveTo calls to nearby points may be used to draw smooth curves.    */
+ *   The farther you move at once, the dimmer the line.                      */
 extern void moveTo(double x, double y);
 
 
@@ -93,6 +134,25 @@ extern void moveTo(double x, double y);
 extern void lineTo(double x, double y, double weight);
 
 
+/* Curves: draw from the last point along a curve, with weight as for lineTo.
+ *   They're much cheaper than lots of short lines: the scope renders them
+ *   straight to samples, as finely as the curve's size and weight call for,
+ *   and each only uses up 3 of MAX_POINTS per Bezier or quarter turn. The
+ *   window splits them into lines a few pixels long.
+ *
+ *   quadTo: quadratic Bezier toward (x1,y1), ending at (x,y)
+ *   cubicTo: cubic Bezier toward (x1,y1) then (x2,y2), ending at (x,y)
+ *   arcTo: circular arc around (cx,cy), turning angle radians, positive from
+ *     the X axis toward the Y axis. The radius is the distance from the last
+ *     point. If setScale's axes are different sizes, circles become ellipses.
+ *   circle: a whole circle of radius r around (x,y), starting with a moveTo
+ *     to its right-hand side                                                 */
+extern void quadTo(double x1, double y1, double x, double y, double weight);
+extern void cubicTo(double x1, double y1, double x2, double y2, double x, double y, double weight);
+extern void arcTo(double cx, double cy, double angle, double weight);
+extern void circle(double x, double y, double r, double weight);
+
+
 /* flip: switch the current display to what has been drawn using moveTo/lineTo.
  *   Note that partial frames will never be drawn. New frames submitted using
  *   flip wait until whatever's currently on-screen finishes drawing. If there
@@ -113,7 +173,178 @@ extern void flip(int clear);
  *     & 4 : swap X and Y axes                                                */
 extern void setMode(int mode);
 
+/* setWrap: if enable is nonzero, the screen wraps around like the Asteroids
+ *   universe: the parts of a shape that go off one edge are drawn coming in
+ *   at the opposite edge too. A shape is everything from one moveTo to the
+ *   next, so each must start with a moveTo. Off by default.                 */
+extern void setWrap(int enable);
+
+/* setInterpolate: if enable is nonzero, the scope moves objects smoothly
+ *   between ticks. A game that only moves things every 50ms (one tick, ended
+ *   by flip(1)) has each frame drawn over and over until the next, so fast
+ *   things jump. With this on, each time the scope draws the frame again, the
+ *   objects in it are moved and turned part way from where they were last
+ *   tick to where they are now, taking as long as a tick did. So the picture
+ *   runs one tick behind the game, but nothing more has to be simulated.
+ *   Objects are marked with beginObject/endObject; anything else stays put.
+ *   Off by default. The scope renders frames with moving objects in the
+ *   audio callback, like "scope:lazy"; the other backends draw them where
+ *   they are now.                                                           */
+extern void setInterpolate(int enable);
+
+/* beginObject: everything drawn until endObject is one object, centered on
+ *   (x,y) and turned angle radians this tick, however the program works out
+ *   its points. An object drawn last tick with the same id moves from there.
+ *   Give it a new id if it's a new object, so it doesn't fly across from
+ *   wherever the old one was. With setWrap on, it goes the short way across
+ *   the edge; otherwise anything that jumped more than half the screen just
+ *   appears. Objects are clipped to the screen where they are now, so one
+ *   crossing an edge waits at the edge for the part of the tick it was on
+ *   the other side. Does nothing (except for gfxRecord) without
+ *   setInterpolate.                                                          */
+extern void beginObject(int id, double x, double y, double angle);
+extern void endObject(void);
+
+/* setFrameQueue: set how many frames can wait to be drawn, and what flip does
+ *   when that many are already waiting.
+ *   depth: 1 to FRAME_QUEUE_MAX frames
+ *   policy: one of
+ *     QUEUE_LATEST: the new frame replaces all waiting frames. Lowest latency,
+ *       best for playing. This is the default, and depth doesn't matter.
+ *     QUEUE_FIFO: flip waits until there's room. Every frame gets drawn at
+ *       least once, for recording, but the program gets held up if it draws
+ *       faster than the scope can.
+ *     QUEUE_DROP_OLDEST: the oldest waiting frame is thrown away.
+ *   The window backend draws immediately and ignores this.                   */
+#define FRAME_QUEUE_MAX 16
+#define QUEUE_LATEST 0
+#define QUEUE_FIFO 1
+#define QUEUE_DROP_OLDEST 2
+extern void setFrameQueue(int depth, int policy);
+
+/* setMidFrameSwitch: if enable is nonzero, a waiting frame takes over at the
+ *   next stroke boundary (a moveTo) instead of the end of the current frame.
+ *   Drawing picks up at the matching stroke boundary the same fraction of the
+ *   way through the new frame, so the beam carries on sweeping the screen
+ *   rather than starting over. Cuts latency by up to a whole frame when the
+ *   picture is busy. Off by default, and never done with QUEUE_FIFO.
+ *   The window backend ignores this.                                          */
+extern void setMidFrameSwitch(int enable);
+
+/* setSimplify: if enable is nonzero, each frame's points are simplified before
+ *   it's rendered, without changing what's drawn:
+ *     - a stroke that exactly retraces the one before it (drawn twice to make
+ *       it brighter) is folded into it, with the weights added up, which
+ *       saves the jump back to its start
+ *     - lines that carry straight on at the same brightness become one line
+ *     - runs of dwells on the same spot become one dwell
+ *   How many points and samples it saved is printed when the program exits.
+ *   Off by default. The window backend ignores this.                         */
+extern void setSimplify(int enable);
+
+/* setStabilize: sound card outputs are AC coupled, so a picture that isn't
+ *   balanced around the middle of the screen drifts and wobbles. A faint box
+ *   around the edge of the screen every so often keeps it steady. With
+ *   interval > 0, one is drawn whenever the beam has spent interval samples
+ *   drawing since the last one, and at least once a frame. It only goes in
+ *   between strokes (at a moveTo), starting from the corner nearest the beam.
+ *   How many samples the boxes took is printed when the program exits.
+ *   0 (the default) turns it off. The window backend ignores this.           */
+extern void setStabilize(int interval);
+
+/* getBeamStats: where the beam's time goes. Each sample of each frame that
+ *   flip renders is counted as one of:
+ *     BEAM_LINE: drawing a line or curve
+ *     BEAM_DWELL: sitting on one spot to make a bright dot
+ *     BEAM_JUMP: going from one stroke to the next (a moveTo, or a line of
+ *       weight 0)
+ *     BEAM_BORDER: getting to and drawing the stabilizing border (see
+ *       setStabilize)
+ *   For each, frame is the samples in the last frame, recent the average over
+ *   about the last 16, and total the samples in all frames so far, so jumps
+ *   or borders eating into the refresh rate show up next to the lines
+ *   actually drawn. Counted after setSimplify, so they're the samples sent.
+ *   All zero for the window backend, which doesn't use samples.              */
+#define BEAM_LINE 0
+#define BEAM_DWELL 1
+#define BEAM_JUMP 2
+#define BEAM_BORDER 3
+#define BEAM_KINDS 4
+struct beamStats {
+	long frame[BEAM_KINDS];
+	double recent[BEAM_KINDS];
+	long total[BEAM_KINDS];
+	long frames;	//frames counted in total
+};
+extern void getBeamStats(struct beamStats *bs);
+
+/* setHeatMap: add up the beam's time in each cell of a 64x64 grid over the
+ *   screen, from now on, and write it to filename when the program exits. It's
+ *   a plain text PGM image, so any image viewer shows it, with the busiest
+ *   cell white; comments at the top give the real numbers of samples. The
+ *   grid is the screen as setScale sees it, before setMode turns it around.
+ *   NULL stops it without writing anything. The window backend ignores this. */
+extern void setHeatMap(const char *filename);
+
+/* returns the number of frames currently waiting to be drawn                 */
+extern int getQueuedFrames(void);
+
+/* returns the number of frames thrown away without being drawn so far        */
+extern long getDroppedFrames(void);
+
 /* returns the refresh rate of the last submitted frame, in Hz                */
 extern double getRefreshRate(void);
 
+/* gfxRecord: start recording all draw calls to a file
+ *   Every draw, flip, setMode, setScale, setWrap, beginObject and endObject
+ *   call from now on is written to filename in a compact binary format (see gfx_record.h), which
+ *   the replay program can play back through either backend. Recording to a
+ *   new file stops the old one. Pass NULL to stop recording.                 */
+extern void gfxRecord(const char *filename);
+
+/* Contexts: everything above draws on one default context, made by gfxInit.
+ * For more than one picture at once (a scope plus a file of the same game, a
+ * server rendering several, a benchmark), make more with gfxCreate and use
+ * the gfx* versions of the calls above, which each take the context first.
+ * Contexts have nothing in common, so each can be driven from its own thread,
+ * but a single context must only be used from one thread at a time.
+ * There's only one sound card and one window per program, so at most one
+ * context can be "scope" and one "window" (counting those inside a tee);
+ * the rest can be "shm", "file" or "null". Only the default context is
+ * recorded by gfxRecord.                                                     */
+typedef struct gfxContext gfxContext;
+
+/* gfxCreate: make a new context drawing on backend, named as for
+ *   gfxSelectBackend (NULL for the default), and initialized as by gfxInit.  */
+extern gfxContext *gfxCreate(const char *backend, int freq, int buffer);
+
+/* gfxDestroy: stop drawing and free everything the context uses             */
+extern void gfxDestroy(gfxContext *ctx);
+
+/* gfxDefaultContext: the context that gfxInit made                          */
+extern gfxContext *gfxDefaultContext(void);
+
+extern void gfxSetScale(gfxContext *ctx, double xleft, double xright, double ytop, double ybottom, double weight);
+extern void gfxMoveTo(gfxContext *ctx, double x, double y);
+extern void gfxLineTo(gfxContext *ctx, double x, double y, double weight);
+extern void gfxQuadTo(gfxContext *ctx, double x1, double y1, double x, double y, double weight);
+extern void gfxCubicTo(gfxContext *ctx, double x1, double y1, double x2, double y2, double x, double y, double weight);
+extern void gfxArcTo(gfxContext *ctx, double cx, double cy, double angle, double weight);
+extern void gfxCircle(gfxContext *ctx, double x, double y, double r, double weight);
+extern void gfxFlip(gfxContext *ctx, int clear);
+extern void gfxSetMode(gfxContext *ctx, int mode);
+extern void gfxSetWrap(gfxContext *ctx, int enable);
+extern void gfxSetInterpolate(gfxContext *ctx, int enable);
+extern void gfxBeginObject(gfxContext *ctx, int id, double x, double y, double angle);
+extern void gfxEndObject(gfxContext *ctx);
+extern void gfxSetFrameQueue(gfxContext *ctx, int depth, int policy);
+extern void gfxSetMidFrameSwitch(gfxContext *ctx, int enable);
+extern void gfxSetSimplify(gfxContext *ctx, int enable);
+extern void gfxSetStabilize(gfxContext *ctx, int interval);
+extern int gfxGetQueuedFrames(gfxContext *ctx);
+extern long gfxGetDroppedFrames(gfxContext *ctx);
+extern double gfxGetRefreshRate(gfxContext *ctx);
+extern void gfxGetBeamStats(gfxContext *ctx, struct beamStats *bs);
+extern void gfxSetHeatMap(gfxContext *ctx, const char *filename);
+
 #endif
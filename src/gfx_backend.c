@@ -0,0 +1,407 @@
+/* Picks a backend at runtime and passes gfx.h calls on to it (see gfx_backend.h)
+ *
+ * Build with -DGFX_DEFAULT_BACKEND=\"name\" to change which backend is used if
+ * the program never calls gfxSelectBackend. The makefile does this to build
+ * asteroids-window and friends from the same code.
+ *
+ * The plain gfx.h calls all draw on a default context that gfxInit creates
+ * with the selected backend, and that gets destroyed at exit. Only those calls
+ * are recorded by gfxRecord.
+ *
+ * I'm releasing this code under the WTFPL. You can do whatever you like with
+ * it, though I'd appreciate credit and thanks if you find it useful or fun.
+ * See LICENSE.txt for details.
+ *            -Joe McKenzie / Chupi
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "gfx.h"
+#include "gfx_backend.h"
+#include "gfx_clip.h"
+#include "gfx_record.h"
+
+#define PI 3.14159265358979323846
+
+#define MAX_OBJECTS 256	//objects a tick that can be interpolated (see setInterpolate)
+
+#ifndef GFX_DEFAULT_BACKEND
+#define GFX_DEFAULT_BACKEND "scope"
+#endif
+
+static const struct gfxBackend *backends[] = {
+	&scopeBackend,
+	&windowBackend,
+	&shmBackend,
+	&fileBackend,
+	&nullBackend,
+	&teeBackend,
+};
+#define NBACKENDS (int)(sizeof(backends)/sizeof(backends[0]))
+
+//where beginObject said an object was
+struct pose {
+	int id;
+	double x, y, angle;
+};
+
+struct gfxContext {
+	const struct gfxBackend *be;
+	void *st;
+	struct clipper clip;	//everything drawn goes through here, which knows the current point
+
+	//interpolating? poses[tick] are the objects drawn since the last flip(1), the other ones before that
+	int interpolate;
+	struct pose poses[2][MAX_OBJECTS];
+	int nposes[2], tick;
+};
+
+//what gfxInit uses, picked with gfxSelectBackend
+static const struct gfxBackend *backend = NULL;
+static char backendArg[256];
+static gfxContext *defaultContext = NULL;
+
+const struct gfxBackend *gfxFindBackend(const char *name, int len) {
+	int i;
+
+	for(i=0; i<NBACKENDS; i++)
+		if((int)strlen(backends[i]->name) == len && !strncmp(backends[i]->name, name, len))
+			return backends[i];
+
+	fprintf(stderr, "Unknown backend %.*s. Choose one of:\n", len, name);
+	gfxListBackends(stderr);
+	exit(1);
+}
+
+void gfxSelectBackend(const char *name) {
+	const char *colon = strchr(name, ':');
+
+	if(defaultContext) {
+		fprintf(stderr, "gfxSelectBackend: too late, gfxInit was already called\n");
+		exit(1);
+	}
+
+	backend = gfxFindBackend(name, colon ? colon - name : (int)strlen(name));
+	backendArg[0] = 0;
+	if(colon) snprintf(backendArg, sizeof(backendArg), "%s", colon+1);
+}
+
+void gfxListBackends(FILE *f) {
+	int i;
+
+	for(i=0; i<NBACKENDS; i++)
+		fprintf(f, "  %-8s %s%s\n", backends[i]->name, backends[i]->desc,
+			strcmp(backends[i]->name, GFX_DEFAULT_BACKEND) ? "" : " (default)");
+}
+
+gfxContext *gfxCreate(const char *name, int freq, int buffer) {
+	gfxContext *ctx = malloc(sizeof(gfxContext));
+	const char *colon;
+
+	if(ctx == NULL) {
+		fprintf(stderr, "gfxCreate: out of memory\n");
+		exit(1);
+	}
+	if(name == NULL) name = GFX_DEFAULT_BACKEND;
+	colon = strchr(name, ':');
+	ctx->be = gfxFindBackend(name, colon ? colon - name : (int)strlen(name));
+	ctx->st = ctx->be->init(freq, buffer, colon ? colon+1 : NULL);
+	clipInit(&ctx->clip, ctx->be, ctx->st);
+	ctx->interpolate = 0;
+	ctx->nposes[0] = ctx->nposes[1] = 0;
+	ctx->tick = 0;
+	return ctx;
+}
+
+void gfxDestroy(gfxContext *ctx) {
+	if(ctx == NULL) return;
+	if(ctx == defaultContext) defaultContext = NULL;
+	ctx->be->destroy(ctx->st);
+	clipFree(&ctx->clip);
+	free(ctx);
+}
+
+//the default context's calls are recorded, if gfxRecord is on
+
+void gfxSetScale(gfxContext *ctx, double xleft, double xright, double ytop, double ybottom, double weight) {
+	if(ctx == defaultContext) recSetScale(xleft, xright, ytop, ybottom, weight);
+	clipFlush(&ctx->clip);
+	clipSetScale(&ctx->clip, xleft, xright, ytop, ybottom);
+	ctx->be->setScale(ctx->st, xleft, xright, ytop, ybottom, weight);
+}
+
+void gfxMoveTo(gfxContext *ctx, double x, double y) {
+	if(ctx == defaultContext) REC_MOVETO(x, y);
+	clipMoveTo(&ctx->clip, x, y);
+}
+
+void gfxLineTo(gfxContext *ctx, double x, double y, double weight) {
+	if(ctx == defaultContext) REC_LINETO(x, y, weight);
+	clipLineTo(&ctx->clip, x, y, weight);
+}
+
+void gfxCubicTo(gfxContext *ctx, double x1, double y1, double x2, double y2, double x, double y, double weight) {
+	if(ctx == defaultContext) REC_CUBICTO(x1, y1, x2, y2, x, y, weight);
+	clipCubicTo(&ctx->clip, x1, y1, x2, y2, x, y, weight);
+}
+
+//a quadratic Bezier is exactly a cubic with its control point 2/3 of the way along each side
+void gfxQuadTo(gfxContext *ctx, double x1, double y1, double x, double y, double weight) {
+	gfxCubicTo(ctx, ctx->clip.x + (x1-ctx->clip.x)*2/3, ctx->clip.y + (y1-ctx->clip.y)*2/3,
+		x + (x1-x)*2/3, y + (y1-y)*2/3, x, y, weight);
+}
+
+//arcs are made of cubics up to a quarter turn each, which are within 0.03% of the radius
+//done in the program's coordinates, so setScale can stretch circles into ellipses
+void gfxArcTo(gfxContext *ctx, double cx, double cy, double angle, double weight) {
+	double r = hypot(ctx->clip.x-cx, ctx->clip.y-cy);
+	double a0 = atan2(ctx->clip.y-cy, ctx->clip.x-cx), a1, step, k;
+	int i, n = (int)ceil(fabs(angle) / (PI/2));
+
+	if(n < 1) return;
+	step = angle/n;
+	//control arm length for a circular arc of step radians
+	k = 4.0/3.0 * tan(step/4) * r;
+	for(i=0; i<n; i++) {
+		a1 = a0 + step;
+		gfxCubicTo(ctx, cx + r*cos(a0) - k*sin(a0), cy + r*sin(a0) + k*cos(a0),
+			cx + r*cos(a1) + k*sin(a1), cy + r*sin(a1) - k*cos(a1),
+			cx + r*cos(a1), cy + r*sin(a1), weight);
+		a0 = a1;
+	}
+}
+
+void gfxCircle(gfxContext *ctx, double x, double y, double r, double weight) {
+	gfxMoveTo(ctx, x+r, y);
+	gfxArcTo(ctx, x, y, 2*PI, weight);
+}
+
+void gfxFlip(gfxContext *ctx, int clear) {
+	if(ctx == defaultContext) REC_FLIP(clear);
+	clipFlush(&ctx->clip);
+	ctx->be->flip(ctx->st, clear);
+	//on to the next tick
+	if(clear) {
+		ctx->tick = !ctx->tick;
+		ctx->nposes[ctx->tick] = 0;
+	}
+}
+
+void gfxBeginObject(gfxContext *ctx, int id, double x, double y, double angle) {
+	struct clipper *c = &ctx->clip;
+	struct pose *p;
+	double m[5], w = c->x1 - c->x0, h = c->y1 - c->y0;
+	int i, last = !ctx->tick;
+
+	if(ctx == defaultContext) REC_BEGINOBJECT(id, x, y, angle);
+	if(!ctx->interpolate) return;
+
+	if(ctx->nposes[ctx->tick] < MAX_OBJECTS) {
+		p = &ctx->poses[ctx->tick][ctx->nposes[ctx->tick]++];
+		p->id = id;
+		p->x = x;
+		p->y = y;
+		p->angle = angle;
+	}
+
+	//where was it last tick?
+	for(i=0; i<ctx->nposes[last] && ctx->poses[last][i].id != id; i++);
+	if(i == ctx->nposes[last]) {
+		//it's new, so it just appears
+		clipSetMotion(c, NULL);
+		return;
+	}
+	p = &ctx->poses[last][i];
+	m[0] = x;
+	m[1] = y;
+	m[2] = p->x - x;
+	m[3] = p->y - y;
+	m[4] = remainder(p->angle - angle, 2*PI);	//the short way round
+	//if it went off one edge and came back at the other, it moved the short way too
+	if(c->wrap) {
+		if(m[2] > w/2) m[2] -= w;
+		else if(m[2] < -w/2) m[2] += w;
+		if(m[3] > h/2) m[3] -= h;
+		else if(m[3] < -h/2) m[3] += h;
+	}
+	//and anything that jumped more than half the screen was put there, not moved
+	clipSetMotion(c, fabs(m[2]) > fabs(w)/2 || fabs(m[3]) > fabs(h)/2 ? NULL : m);
+}
+
+void gfxEndObject(gfxContext *ctx) {
+	if(ctx == defaultContext) REC_ENDOBJECT();
+	if(ctx->interpolate) clipSetMotion(&ctx->clip, NULL);
+}
+
+void gfxSetInterpolate(gfxContext *ctx, int enable) {
+	ctx->interpolate = enable;
+	ctx->nposes[0] = ctx->nposes[1] = 0;
+	clipSetMotion(&ctx->clip, NULL);
+}
+
+void gfxSetMode(gfxContext *ctx, int mode) {
+	if(ctx == defaultContext) recSetMode(mode);
+	clipFlush(&ctx->clip);
+	ctx->be->setMode(ctx->st, mode);
+}
+
+void gfxSetWrap(gfxContext *ctx, int enable) {
+	if(ctx == defaultContext) recSetWrap(enable);
+	clipSetWrap(&ctx->clip, enable);
+}
+
+void gfxSetFrameQueue(gfxContext *ctx, int depth, int policy) {
+	if(ctx->be->setFrameQueue) ctx->be->setFrameQueue(ctx->st, depth, policy);
+}
+
+void gfxSetMidFrameSwitch(gfxContext *ctx, int enable) {
+	if(ctx->be->setMidFrameSwitch) ctx->be->setMidFrameSwitch(ctx->st, enable);
+}
+
+void gfxSetSimplify(gfxContext *ctx, int enable) {
+	if(ctx->be->setSimplify) ctx->be->setSimplify(ctx->st, enable);
+}
+
+void gfxSetStabilize(gfxContext *ctx, int interval) {
+	if(ctx->be->setStabilize) ctx->be->setStabilize(ctx->st, interval);
+}
+
+int gfxGetQueuedFrames(gfxContext *ctx) {
+	return ctx->be->getQueuedFrames ? ctx->be->getQueuedFrames(ctx->st) : 0;
+}
+
+long gfxGetDroppedFrames(gfxContext *ctx) {
+	return ctx->be->getDroppedFrames ? ctx->be->getDroppedFrames(ctx->st) : 0;
+}
+
+double gfxGetRefreshRate(gfxContext *ctx) {
+	return ctx->be->getRefreshRate ? ctx->be->getRefreshRate(ctx->st) : 0.0;
+}
+
+void gfxGetBeamStats(gfxContext *ctx, struct beamStats *bs) {
+	memset(bs, 0, sizeof(struct beamStats));
+	if(ctx->be->getBeamStats) ctx->be->getBeamStats(ctx->st, bs);
+}
+
+void gfxSetHeatMap(gfxContext *ctx, const char *filename) {
+	if(ctx->be->setHeatMap) ctx->be->setHeatMap(ctx->st, filename);
+}
+
+//everything below draws on the default context, which gfxInit creates
+
+//before SDL_Quit, which is registered earlier so runs later
+static void destroyDefault(void) {
+	gfxDestroy(defaultContext);
+}
+
+void gfxInit(int freq, int buffer) {
+	char name[300];
+
+	if(defaultContext) {
+		fprintf(stderr, "gfxInit: already called\n");
+		exit(1);
+	}
+	if(backend == NULL) gfxSelectBackend(GFX_DEFAULT_BACKEND);
+	if(backendArg[0]) snprintf(name, sizeof(name), "%s:%s", backend->name, backendArg);
+	else snprintf(name, sizeof(name), "%s", backend->name);
+	defaultContext = gfxCreate(name, freq, buffer);
+	atexit(destroyDefault);
+}
+
+gfxContext *gfxDefaultContext(void) {
+	if(defaultContext == NULL) {
+		fprintf(stderr, "Graphics used before gfxInit\n");
+		exit(1);
+	}
+	return defaultContext;
+}
+
+void setScale(double xleft, double xright, double ytop, double ybottom, double weight) {
+	gfxSetScale(gfxDefaultContext(), xleft, xright, ytop, ybottom, weight);
+}
+
+void moveTo(double x, double y) {
+	gfxMoveTo(defaultContext, x, y);
+}
+
+void lineTo(double x, double y, double weight) {
+	gfxLineTo(defaultContext, x, y, weight);
+}
+
+void quadTo(double x1, double y1, double x, double y, double weight) {
+	gfxQuadTo(defaultContext, x1, y1, x, y, weight);
+}
+
+void cubicTo(double x1, double y1, double x2, double y2, double x, double y, double weight) {
+	gfxCubicTo(defaultContext, x1, y1, x2, y2, x, y, weight);
+}
+
+void arcTo(double cx, double cy, double angle, double weight) {
+	gfxArcTo(defaultContext, cx, cy, angle, weight);
+}
+
+void circle(double x, double y, double r, double weight) {
+	gfxCircle(defaultContext, x, y, r, weight);
+}
+
+void beginObject(int id, double x, double y, double angle) {
+	gfxBeginObject(defaultContext, id, x, y, angle);
+}
+
+void endObject(void) {
+	gfxEndObject(defaultContext);
+}
+
+void setInterpolate(int enable) {
+	gfxSetInterpolate(gfxDefaultContext(), enable);
+}
+
+void flip(int clear) {
+	gfxFlip(gfxDefaultContext(), clear);
+}
+
+void setMode(int mode) {
+	gfxSetMode(gfxDefaultContext(), mode);
+}
+
+void setWrap(int enable) {
+	gfxSetWrap(gfxDefaultContext(), enable);
+}
+
+void setFrameQueue(int depth, int policy) {
+	gfxSetFrameQueue(gfxDefaultContext(), depth, policy);
+}
+
+void setMidFrameSwitch(int enable) {
+	gfxSetMidFrameSwitch(gfxDefaultContext(), enable);
+}
+
+void setSimplify(int enable) {
+	gfxSetSimplify(gfxDefaultContext(), enable);
+}
+
+void setStabilize(int interval) {
+	gfxSetStabilize(gfxDefaultContext(), interval);
+}
+
+int getQueuedFrames(void) {
+	return gfxGetQueuedFrames(gfxDefaultContext());
+}
+
+long getDroppedFrames(void) {
+	return gfxGetDroppedFrames(gfxDefaultContext());
+}
+
+double getRefreshRate(void) {
+	return gfxGetRefreshRate(gfxDefaultContext());
+}
+
+void getBeamStats(struct beamStats *bs) {
+	gfxGetBeamStats(gfxDefaultContext(), bs);
+}
+
+void setHeatMap(const char *filename) {
+	gfxSetHeatMap(gfxDefaultContext(), filename);
+}
@@ -0,0 +1,74 @@
+/* Interface between gfx.h and the backends that actually draw
+ *
+ * Every function in gfx.h goes through gfx_backend.c, which calls the
+ * context's backend through one of these tables (and records it first, if
+ * it's the default context and gfxRecord is on). Each context gets its own
+ * instance of the backend, with its own state. The tables are:
+ *    scope:  render to PCM and play it on the sound card (gfx.c)
+ *    shm:    render to PCM and publish it in shared memory (gfx.c, gfx_shm.h)
+ *    file:   render to PCM and append each frame to a raw file once (gfx.c)
+ *    null:   render to PCM and throw it away, for timing the renderer (gfx.c)
+ *    window: draw in an SDL window (gfx_debug.c)
+ *    tee:    pass everything on to two of the others at once (gfx_tee.c)
+ *
+ * Any of the optional functions may be NULL if the backend has nothing to do
+ * for them; the dispatcher then does nothing, or returns 0.
+ *
+ * I'm releasing this code under the WTFPL. You can do whatever you like with
+ * it, though I'd appreciate credit and thanks if you find it useful or fun.
+ * See LICENSE.txt for details.
+ *            -Joe McKenzie / Chupi
+ */
+
+#ifndef __GFX_BACKEND_H__
+#define __GFX_BACKEND_H__
+
+#include "gfx.h"
+
+struct gfxBackend {
+	const char *name;	//what -backend calls it
+	const char *desc;	//one line for the usage message
+
+	//init returns the new instance's state, which is passed to all the rest
+	//arg is whatever came after a ':' in the backend name, or NULL
+	void *(*init)(int freq, int buffer, const char *arg);
+	void (*destroy)(void *st);
+	void (*setScale)(void *st, double xleft, double xright, double ytop, double ybottom, double weight);
+	void (*moveTo)(void *st, double x, double y);
+	void (*lineTo)(void *st, double x, double y, double weight);
+	//cubic Bezier from the current point; quadTo, arcTo and circle are made of these
+	void (*cubicTo)(void *st, double x1, double y1, double x2, double y2, double x, double y, double weight);
+	void (*flip)(void *st, int clear);
+	void (*setMode)(void *st, int mode);
+
+	//optional
+	void (*setFrameQueue)(void *st, int depth, int policy);
+	void (*setMidFrameSwitch)(void *st, int enable);
+	int (*getQueuedFrames)(void *st);
+	long (*getDroppedFrames)(void *st);
+	double (*getRefreshRate)(void *st);
+	void (*setSimplify)(void *st, int enable);
+	void (*setStabilize)(void *st, int interval);
+	//everything drawn from now on moved with motion since the last tick (see beginObject in gfx.h):
+	//{cx, cy, dx, dy, da} means it's centered on (cx,cy) now, and was (dx,dy) away and turned
+	//da radians further back then. NULL for things that haven't moved.
+	void (*setMotion)(void *st, const double *motion);
+	//bs is zeroed first, so only what's counted needs filling in
+	void (*getBeamStats)(void *st, struct beamStats *bs);
+	void (*setHeatMap)(void *st, const char *filename);
+	//for backends that can only show frames on the thread that made them (the window), when
+	//something else draws on another thread: after deferPresent, flip only gets each frame
+	//ready, and present shows the newest one ready. Both called on the thread that made it.
+	void (*deferPresent)(void *st);
+	void (*present)(void *st);
+};
+
+extern const struct gfxBackend scopeBackend, shmBackend, fileBackend, nullBackend;
+extern const struct gfxBackend windowBackend;
+extern const struct gfxBackend teeBackend;
+
+/* gfxFindBackend: look up a backend by the first len characters of name.
+ *   Prints the list of backends and exits if there's no such backend.       */
+extern const struct gfxBackend *gfxFindBackend(const char *name, int len);
+
+#endif
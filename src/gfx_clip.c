@@ -0,0 +1,323 @@
+/* Clipping draw calls to the screen, with an optional toroidal mode (see gfx_clip.h)
+ *
+ * I'm releasing this code under the WTFPL. You can do whatever you like with
+ * it, though I'd appreciate credit and thanks if you find it useful or fun.
+ * See LICENSE.txt for details.
+ *            -Joe McKenzie / Chupi
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "gfx_clip.h"
+
+//Cohen-Sutherland outcodes
+#define OUT_LEFT 1
+#define OUT_RIGHT 2
+#define OUT_TOP 4
+#define OUT_BOTTOM 8
+
+//how many times a curve crossing an edge is halved before the pieces on the edge become lines
+#define CURVE_DEPTH 6
+
+enum { CMD_MOVE, CMD_LINE, CMD_CUBIC };
+
+struct clipCmd {
+	int op;
+	double a[7];	//the call's arguments in order
+};
+
+void clipInit(struct clipper *c, const struct gfxBackend *be, void *st) {
+	c->be = be;
+	c->st = st;
+	c->x = c->y = 0;
+	c->penHere = 1;	//the backend starts its first stroke wherever we do
+	c->wrap = 0;
+	c->moving = 0;
+	c->cmds = NULL;
+	c->n = c->max = 0;
+	clipSetScale(c, 0, 1000, 0, 1000);
+}
+
+void clipFree(struct clipper *c) {
+	free(c->cmds);
+	c->cmds = NULL;
+}
+
+void clipSetScale(struct clipper *c, double xleft, double xright, double ytop, double ybottom) {
+	c->x0 = xleft < xright ? xleft : xright;
+	c->x1 = xleft < xright ? xright : xleft;
+	c->y0 = ytop < ybottom ? ytop : ybottom;
+	c->y1 = ytop < ybottom ? ybottom : ytop;
+	c->clipX = xleft != xright;
+	c->clipY = ytop != ybottom;
+}
+
+void clipSetWrap(struct clipper *c, int enable) {
+	clipFlush(c);
+	c->wrap = enable;
+}
+
+//motion shifted along with a wrapped copy of what it applies to
+static void sendMotion(struct clipper *c, double dx, double dy) {
+	double m[5];
+	int i;
+
+	if(c->be->setMotion == NULL) return;
+	if(!c->moving) {
+		c->be->setMotion(c->st, NULL);
+		return;
+	}
+	for(i=0; i<5; i++) m[i] = c->motion[i];
+	m[0] += dx;
+	m[1] += dy;
+	c->be->setMotion(c->st, m);
+}
+
+void clipSetMotion(struct clipper *c, const double *motion) {
+	int i;
+
+	clipFlush(c);
+	c->moving = motion != NULL;
+	if(c->moving)
+		for(i=0; i<5; i++) c->motion[i] = motion[i];
+	sendMotion(c, 0, 0);
+}
+
+static int outcode(const struct clipper *c, double x, double y) {
+	int code = 0;
+
+	if(c->clipX) {
+		if(x < c->x0) code |= OUT_LEFT;
+		else if(x > c->x1) code |= OUT_RIGHT;
+	}
+	if(c->clipY) {
+		if(y < c->y0) code |= OUT_TOP;
+		else if(y > c->y1) code |= OUT_BOTTOM;
+	}
+	return code;
+}
+
+//cut the line from a to b down to the part on screen
+//returns 0 if none of it is
+static int clipSegment(const struct clipper *c, double *ax, double *ay, double *bx, double *by) {
+	int ca = outcode(c, *ax, *ay), cb = outcode(c, *bx, *by), code;
+	double x, y;
+
+	while(1) {
+		if(!(ca | cb)) return 1;	//all on screen
+		if(ca & cb) return 0;	//both off the same edge
+
+		//move whichever end is off screen to the edge it's beyond
+		code = ca ? ca : cb;
+		if(code & OUT_TOP) {
+			x = *ax + (*bx-*ax)*(c->y0-*ay)/(*by-*ay);
+			y = c->y0;
+		} else if(code & OUT_BOTTOM) {
+			x = *ax + (*bx-*ax)*(c->y1-*ay)/(*by-*ay);
+			y = c->y1;
+		} else if(code & OUT_LEFT) {
+			y = *ay + (*by-*ay)*(c->x0-*ax)/(*bx-*ax);
+			x = c->x0;
+		} else {
+			y = *ay + (*by-*ay)*(c->x1-*ax)/(*bx-*ax);
+			x = c->x1;
+		}
+		if(code == ca) {
+			*ax = x;
+			*ay = y;
+			ca = outcode(c, x, y);
+		} else {
+			*bx = x;
+			*by = y;
+			cb = outcode(c, x, y);
+		}
+	}
+}
+
+static void move(struct clipper *c, double x, double y) {
+	//off screen, the pen waits until something brings it back on
+	c->penHere = !outcode(c, x, y);
+	if(c->penHere) c->be->moveTo(c->st, x, y);
+}
+
+static void line(struct clipper *c, double ax, double ay, double bx, double by, double weight) {
+	double sx = ax, sy = ay, ex = bx, ey = by;
+
+	if(!clipSegment(c, &ax, &ay, &bx, &by)) {
+		c->penHere = 0;
+		return;
+	}
+	//jump to where it comes onto the screen
+	if(!c->penHere || ax != sx || ay != sy) c->be->moveTo(c->st, ax, ay);
+	c->be->lineTo(c->st, bx, by, weight);
+	c->penHere = bx == ex && by == ey;
+}
+
+static void cubic(struct clipper *c, double x0, double y0, double x1, double y1, double x2, double y2, double x3, double y3, double weight, int depth) {
+	int c0 = outcode(c, x0, y0), c1 = outcode(c, x1, y1), c2 = outcode(c, x2, y2), c3 = outcode(c, x3, y3);
+	double ax, ay, bx, by, mx, my, lx, ly, rx, ry, px, py;
+
+	//the curve stays inside its control points, so if they're all on screen so is the curve
+	if(!(c0 | c1 | c2 | c3)) {
+		if(!c->penHere) c->be->moveTo(c->st, x0, y0);
+		c->be->cubicTo(c->st, x1, y1, x2, y2, x3, y3, weight);
+		c->penHere = 1;
+		return;
+	}
+	//and if they're all off the same edge, none of it is
+	if(c0 & c1 & c2 & c3) {
+		c->penHere = 0;
+		return;
+	}
+	if(depth == 0) {
+		line(c, x0, y0, x3, y3, weight);
+		return;
+	}
+
+	//split it in half (de Casteljau) and try again with each half
+	ax = (x0+x1)/2; ay = (y0+y1)/2;
+	mx = (x1+x2)/2; my = (y1+y2)/2;
+	bx = (x2+x3)/2; by = (y2+y3)/2;
+	lx = (ax+mx)/2; ly = (ay+my)/2;
+	rx = (mx+bx)/2; ry = (my+by)/2;
+	px = (lx+rx)/2; py = (ly+ry)/2;
+	cubic(c, x0, y0, ax, ay, lx, ly, px, py, weight, depth-1);
+	cubic(c, px, py, rx, ry, bx, by, x3, y3, weight, depth-1);
+}
+
+//wrap mode: save a call for when the stroke is finished
+static void addCmd(struct clipper *c, int op, const double *a, int n) {
+	struct clipCmd *cmd;
+	int i;
+
+	if(c->n == c->max) {
+		c->max = c->max ? c->max*2 : 64;
+		c->cmds = realloc(c->cmds, c->max * sizeof(struct clipCmd));
+		if(c->cmds == NULL) {
+			fprintf(stderr, "gfx: out of memory\n");
+			exit(1);
+		}
+	}
+	cmd = &c->cmds[c->n++];
+	cmd->op = op;
+	for(i=0; i<n; i++) cmd->a[i] = a[i];
+
+	//bounding box of all the points, control points included
+	for(i=0; i+1<n; i+=2) {
+		if(c->n == 1 && i == 0) {
+			c->minX = c->maxX = a[0];
+			c->minY = c->maxY = a[1];
+		}
+		if(a[i] < c->minX) c->minX = a[i];
+		if(a[i] > c->maxX) c->maxX = a[i];
+		if(a[i+1] < c->minY) c->minY = a[i+1];
+		if(a[i+1] > c->maxY) c->maxY = a[i+1];
+	}
+}
+
+//wrap mode: start the stroke at the current point if the program didn't start it with moveTo
+static void startStroke(struct clipper *c) {
+	double a[2];
+
+	if(c->n > 0) return;
+	a[0] = c->x;
+	a[1] = c->y;
+	addCmd(c, CMD_MOVE, a, 2);
+}
+
+void clipMoveTo(struct clipper *c, double x, double y) {
+	double a[2];
+
+	if(c->wrap) {
+		clipFlush(c);
+		a[0] = x;
+		a[1] = y;
+		addCmd(c, CMD_MOVE, a, 2);
+	} else move(c, x, y);
+	c->x = x;
+	c->y = y;
+}
+
+void clipLineTo(struct clipper *c, double x, double y, double weight) {
+	double a[3];
+
+	if(c->wrap) {
+		startStroke(c);
+		a[0] = x;
+		a[1] = y;
+		a[2] = weight;
+		addCmd(c, CMD_LINE, a, 3);
+	} else line(c, c->x, c->y, x, y, weight);
+	c->x = x;
+	c->y = y;
+}
+
+void clipCubicTo(struct clipper *c, double x1, double y1, double x2, double y2, double x, double y, double weight) {
+	double a[7];
+
+	if(c->wrap) {
+		startStroke(c);
+		a[0] = x1;
+		a[1] = y1;
+		a[2] = x2;
+		a[3] = y2;
+		a[4] = x;
+		a[5] = y;
+		a[6] = weight;
+		addCmd(c, CMD_CUBIC, a, 7);
+	} else cubic(c, c->x, c->y, x1, y1, x2, y2, x, y, weight, CURVE_DEPTH);
+	c->x = x;
+	c->y = y;
+}
+
+//the stroke where it is, then shifted across each edge and corner
+static const int shifts[9][2] = {
+	{0, 0},
+	{-1, 0}, {1, 0}, {0, -1}, {0, 1},
+	{-1, -1}, {1, -1}, {-1, 1}, {1, 1},
+};
+
+void clipFlush(struct clipper *c) {
+	double w = c->x1 - c->x0, h = c->y1 - c->y0, dx, dy, px = 0, py = 0;
+	const double *a;
+	int i, k, shifted = 0;
+
+	if(c->n == 0) return;
+	for(i=0; i<9; i++) {
+		dx = shifts[i][0] * w;
+		dy = shifts[i][1] * h;
+		if((dx != 0 && !c->clipX) || (dy != 0 && !c->clipY)) continue;
+		//only the copies that would be on screen; just touching an edge doesn't count
+		if(i > 0 && (c->minX+dx >= c->x1 || c->maxX+dx <= c->x0 || c->minY+dy >= c->y1 || c->maxY+dy <= c->y0))
+			continue;
+
+		if(c->moving && i > 0) {
+			sendMotion(c, dx, dy);
+			shifted = 1;
+		}
+		for(k=0; k<c->n; k++) {
+			a = c->cmds[k].a;
+			switch(c->cmds[k].op) {
+			case CMD_MOVE:
+				move(c, a[0]+dx, a[1]+dy);
+				px = a[0];
+				py = a[1];
+				break;
+			case CMD_LINE:
+				line(c, px+dx, py+dy, a[0]+dx, a[1]+dy, a[2]);
+				px = a[0];
+				py = a[1];
+				break;
+			case CMD_CUBIC:
+				cubic(c, px+dx, py+dy, a[0]+dx, a[1]+dy, a[2]+dx, a[3]+dy, a[4]+dx, a[5]+dy, a[6], CURVE_DEPTH);
+				px = a[4];
+				py = a[5];
+				break;
+			}
+		}
+	}
+	c->n = 0;
+	//the backend's pen is wherever the last copy left it
+	c->penHere = 0;
+	if(shifted) sendMotion(c, 0, 0);
+}
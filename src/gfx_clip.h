@@ -0,0 +1,66 @@
+/* Clipping draw calls to the screen, with an optional toroidal mode
+ *
+ * gfx_backend.c passes every draw call on a context through one of these
+ * before it gets to the backend. Lines are clipped to the screen set by
+ * setScale (Cohen-Sutherland), curves are split where they cross an edge, and
+ * anything entirely off the screen never reaches the backend at all. So the
+ * backends' own clamping to the screen edges only ever has rounding to catch.
+ *
+ * With wrap on (setWrap in gfx.h), each stroke is held back until the next
+ * moveTo or flip. Then it's drawn once where it is, and again shifted by a
+ * screen's width and/or height wherever that copy would be on screen, for a
+ * world that wraps around at the edges. Each copy gets its own setMotion (see
+ * gfx_backend.h), with the center shifted along with it.
+ *
+ * I'm releasing this code under the WTFPL. You can do whatever you like with
+ * it, though I'd appreciate credit and thanks if you find it useful or fun.
+ * See LICENSE.txt for details.
+ *            -Joe McKenzie / Chupi
+ */
+
+#ifndef __GFX_CLIP_H__
+#define __GFX_CLIP_H__
+
+#include "gfx_backend.h"
+
+struct clipCmd;
+
+struct clipper {
+	//where the clipped calls go
+	const struct gfxBackend *be;
+	void *st;
+
+	//screen edges, lowest first; a flattened axis has nothing to clip
+	double x0, x1, y0, y1;
+	int clipX, clipY;
+
+	double x, y;	//current point
+	int penHere;	//is the backend's pen at the current point? (not if it was left at an edge)
+
+	//wrap mode: the stroke so far, and its bounding box
+	int wrap;
+	struct clipCmd *cmds;
+	int n, max;
+	double minX, maxX, minY, maxY;
+
+	//motion for what's being drawn, passed on to the backend (see setMotion in gfx_backend.h)
+	int moving;
+	double motion[5];
+};
+
+extern void clipInit(struct clipper *c, const struct gfxBackend *be, void *st);
+extern void clipFree(struct clipper *c);
+
+//call clipFlush first if anything's been drawn
+extern void clipSetScale(struct clipper *c, double xleft, double xright, double ytop, double ybottom);
+extern void clipSetWrap(struct clipper *c, int enable);
+extern void clipSetMotion(struct clipper *c, const double *motion);
+
+extern void clipMoveTo(struct clipper *c, double x, double y);
+extern void clipLineTo(struct clipper *c, double x, double y, double weight);
+extern void clipCubicTo(struct clipper *c, double x1, double y1, double x2, double y2, double x, double y, double weight);
+
+//draw the stroke held back for wrapping, before a flip or anything else that affects it
+extern void clipFlush(struct clipper *c);
+
+#endif
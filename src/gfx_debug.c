@@ -1,10 +1,26 @@
 /* Screen implementation of the oscilloscope vector graphics system.
  *
- * Binary-compatible with it, and draws in a window instead for easier debugging
- * of programs using it. Draws everything with N-pixel-thick lines, supports
- * weights and setScale. Lines drawn over each other add weights, up to white.
+ * The "window" backend (see gfx_backend.h): draws in a window instead, for easier
+ * debugging of programs using it. Draws everything with LINEWIDTH-pixel-thick lines,
+ * supports weights and setScale. A thick line is drawn in one pass along its length, with
+ * a span of pixels straight across it at each step, so it costs about the same as a thin
+ * one. Lines drawn over each other add weights, up to white. Curves are
+ * split into short lines.
  * MoveTo draws a dim line, like on a real scope.
  *
+ * Vector pictures only cover a small part of the window, so flip only copies
+ * to the screen, and clears, the parts that changed. The window is split into
+ * TILE-pixel tiles, and every pixel drawn marks its tile. flip then updates
+ * the tiles drawn in this frame plus those still showing the last one, as one
+ * rectangle for each run of them along a row. Past FULL_TILES percent of the
+ * window, one update of the whole thing is cheaper than lots of little ones.
+ *
+ * SDL's video functions have to be called from the thread that set the video
+ * mode, so when something else draws on another thread (the tee backend),
+ * it calls windowDeferPresent first. Then drawing goes into a buffer of the
+ * window's own, flip copies the changed tiles of each finished frame aside,
+ * and windowPresent, on the main thread, copies them to the screen.
+ *
  * I'm releasing this code under the WTFPL. You can do whatever you like with
  * it, though I'd appreciate credit and thanks if you find it useful or fun.
  * See LICENSE.txt for details.
@@ -17,66 +33,96 @@
 #include <string.h>
 #include <math.h>
 #include "gfx.h"
+#include "gfx_backend.h"
+#include "prof.h"
 
 #define SIZE 480	//window size (it's always square)
-#define LINEWIDTH 1	//controls line thickness (only odd numbers work right)
+#define LINEWIDTH 1	//line thickness in pixels
+#define TILE 16	//size of the squares changes are tracked in
+#define TILES ((SIZE+TILE-1)/TILE)	//tiles across and down
+#define FULL_TILES 50	//percent of tiles changed that's worth updating the whole window for
+
+//what each tile has in it
+#define TILE_NEW 1	//drawn on since the last flip, so the screen needs updating
+#define TILE_PAINTED 2	//drawn on since the last clear, so it needs clearing
+#define TILE_STALE 4	//cleared, but the screen still shows the last frame there
+
+struct window {
+	SDL_Surface *screen;
+	Uint16 *buf;	//drawn on instead of the screen, once presenting is deferred
+	double xmin, xmax, ymin, ymax, cursX, cursY;
+	int flipX, flipY, swapXY;
+
+	//the window is shades of grey, so a pixel's brightness is a lookup each way
+	//instead of SDL_GetRGB and SDL_MapRGB
+	Uint8 level[65536];
+	Uint16 grey[256];
 
-SDL_Surface *screen;
-double xmin, xmax, ymin, ymax, cursX=0, cursY=0;
-int flipX=0, flipY=0, swapXY=0;
+	Uint8 tiles[TILES*TILES];	//TILE_ flags
+	SDL_Rect rects[TILES*TILES];	//room for every tile, though runs need fewer
 
-void gfxInit(int freq, int buffer) {
+	//frames finished by the drawing thread, for windowPresent to show
+	SDL_mutex *lock;
+	Uint16 *ready;	//the newest, wherever it's different from the screen
+	Uint8 readyTiles[TILES*TILES];	//the tiles of it the screen doesn't have yet
+	SDL_Rect presentRects[TILES*TILES];
+};
+
+//SDL only has the one window
+static int windowOpen = 0;
+
+static void *windowInit(int freq, int buffer, const char *arg) {
 	static const char title[] = "Vector Output Window";
-    screen = SDL_SetVideoMode(SIZE, SIZE, 16, SDL_SWSURFACE);
-    if ( screen == NULL ) {
+	struct window *w;
+	Uint8 r, g, b;
+	int i;
+
+	if(windowOpen) {
+		fprintf(stderr, "Only one window can be open at once.\n");
+		exit(1);
+	}
+	w = calloc(1, sizeof(struct window));
+	w->xmax = 1000;
+	w->ymax = 1000;
+    w->screen = SDL_SetVideoMode(SIZE, SIZE, 16, SDL_SWSURFACE);
+    if ( w->screen == NULL ) {
         fprintf(stderr, "Unable to set video mode: %s\n", SDL_GetError());
         exit(1);
     }
 	 SDL_WM_SetCaption(title, title);
-}
-
-static void plot(int x, int y, Uint8 bright) {
-	Uint8 r, g, b;
-	Uint32 color;
-	Uint16 *bufp;
-	int bright2;
-
-	//clamp to screen size for attempts to draw out of screen
-	if(x<0||x>=SIZE||y<0||y>=SIZE) return;
-
-	if(SDL_MUSTLOCK(screen)) {
-		if(SDL_LockSurface(screen) < 0) {
-			return;
-		}
+	for(i=0; i<65536; i++) {
+		SDL_GetRGB(i, w->screen->format, &r, &g, &b);
+		w->level[i] = r;
 	}
+	for(i=0; i<256; i++) w->grey[i] = SDL_MapRGB(w->screen->format, i, i, i);
+	windowOpen = 1;
+	return w;
+}
 
-	//add if we go over a pixel we've already drawn
-	bufp = (Uint16 *)screen->pixels + y*screen->pitch/2 + x;
-	SDL_GetRGB(*bufp, screen->format, &r, &g, &b);
-	bright2 = bright + r;
-	if(bright2 > 255) bright2=255;
-	bright = (Uint8)bright2;
-	color = SDL_MapRGB(screen->format, bright, bright, bright);
-	*bufp = color;
+//the window itself stays until SDL_Quit
+static void windowDestroy(void *st) {
+	struct window *w = st;
 
-	if(SDL_MUSTLOCK(screen)) {
-		SDL_UnlockSurface(screen);
-	}
+	windowOpen = 0;
+	if(w->lock) SDL_DestroyMutex(w->lock);
+	free(w->buf);
+	free(w->ready);
+	free(w);
 }
 
-void setScale(double xleft, double xright, double ytop, double ybottom, double weight) {
-	xmin = xleft;
-	xmax = xright;
-	ymin = ytop;
-	ymax = ybottom;
-}
+static void drawLine(struct window *w, double x, double y, double weight);
+
+static void windowSetScale(void *st, double xleft, double xright, double ytop, double ybottom, double weight) {
+	struct window *w = st;
 
-void moveTo(double x, double y) {
-	lineTo(x, y, 0);
+	w->xmin = xleft;
+	w->xmax = xright;
+	w->ymin = ytop;
+	w->ymax = ybottom;
 }
 
-static int iabs(int x) {
-	return x<0?-x:x;
+static void windowMoveTo(void *st, double x, double y) {
+	drawLine(st, x, y, 0);
 }
 
 static int clamp(int n) {
@@ -85,19 +131,77 @@ static int clamp(int n) {
 	return n;
 }
 
-//standard Bresenham's line algorithm
+//the pixels across a line at x,y from LINE_LO to LINE_HI: a column if vertical, or a row
+//lines are drawn with the first pixel, even ones with the extra one after it
+#define LINE_LO (-(LINEWIDTH-1)/2)
+#define LINE_HI (LINEWIDTH/2)
+
+//add bright to each pixel in the span, up to white
+//clip: whether the line goes near the edge, so the span needs cutting down to the window
+//pitch: pixels from one row to the next
+static void span(struct window *w, Uint16 *pixels, int pitch, int x, int y, int vertical, Uint8 bright, int clip) {
+	int lo = LINE_LO, hi = LINE_HI, along = vertical ? y : x, across = vertical ? x : y;
+	int step, i, v;
+	Uint16 *p;
+
+	if(clip) {
+		if(across < 0 || across >= SIZE) return;
+		if(along+lo < 0) lo = -along;
+		if(along+hi >= SIZE) hi = SIZE-1-along;
+		if(lo > hi) return;
+	}
+
+	//tiles it's on
+	for(i=(along+lo)/TILE; i<=(along+hi)/TILE; i++)
+		w->tiles[vertical ? i*TILES + x/TILE : (y/TILE)*TILES + i] |= TILE_NEW | TILE_PAINTED;
+
+	//add if we go over a pixel we've already drawn
+	if(vertical) {
+		p = pixels + (y+lo)*pitch + x;
+		step = pitch;
+	} else {
+		p = pixels + y*pitch + x+lo;
+		step = 1;
+	}
+	for(i=lo; i<=hi; i++, p+=step) {
+		v = w->level[*p] + bright;
+		*p = w->grey[v > 255 ? 255 : v];
+	}
+}
+
+//standard Bresenham's line algorithm, with a span across the line at each pixel
 //adapted from http://en.wikipedia.org/wiki/Bresenham%27s_line_algorithm
-static void lineTo2(int x0, int y0, int x1, int y1, Uint8 shade) {
-	int dx, dy, sx, sy, err, e2;
+static void thickLine(struct window *w, int x0, int y0, int x1, int y1, Uint8 shade) {
+	int dx, dy, sx, sy, err, e2, vertical, clip, pitch;
+	Uint16 *pixels;
 
 	dx = abs(x1-x0);
 	dy = abs(y1-y0);
 	if(x0 < x1) sx = 1; else sx = -1;
 	if(y0 < y1) sy = 1; else sy = -1;
 	err = dx - dy;
+	//shallow lines are thickened with columns, steep ones with rows
+	vertical = dx > dy;
+
+	//only lines that get near the edge need clipping (the ends can be just off it)
+	clip = (x0 < x1 ? x0 : x1) + LINE_LO < 0 || (x0 > x1 ? x0 : x1) + LINE_HI >= SIZE ||
+		(y0 < y1 ? y0 : y1) + LINE_LO < 0 || (y0 > y1 ? y0 : y1) + LINE_HI >= SIZE;
+
+	if(w->buf) {
+		pixels = w->buf;
+		pitch = SIZE;
+	} else {
+		if(SDL_MUSTLOCK(w->screen)) {
+			if(SDL_LockSurface(w->screen) < 0) {
+				return;
+			}
+		}
+		pixels = w->screen->pixels;
+		pitch = w->screen->pitch/2;
+	}
 
 	while(1) {
-		plot(x0, y0, shade);
+		span(w, pixels, pitch, x0, y0, vertical, shade, clip);
 		if(x0 == x1 && y0 == y1) break;
 		e2 = 2*err;
 		if(e2 > -dy) {
@@ -109,27 +213,60 @@ static void lineTo2(int x0, int y0, int x1, int y1, Uint8 shade) {
 			y0 += sy;
 		}
 	}
+
+	if(!w->buf && SDL_MUSTLOCK(w->screen)) {
+		SDL_UnlockSurface(w->screen);
+	}
+}
+
+static void windowLineTo(void *st, double x, double y, double weight) {
+	drawLine(st, x, y, weight);
+}
+
+//curves are split into lines about CURVE_PIXELS long on screen
+#define CURVE_PIXELS 4
+#define CURVE_MAX_LINES 64
+
+static void windowCubicTo(void *st, double x1, double y1, double x2, double y2, double x, double y, double weight) {
+	struct window *w = st;
+	double x0 = w->cursX, y0 = w->cursY, sx, sy, len, t, u;
+	int i, n;
+
+	//control polygon length in pixels, which is at least as long as the curve
+	sx = (SIZE-4) / (w->xmax - w->xmin);
+	sy = (SIZE-4) / (w->ymax - w->ymin);
+	len = hypot((x1-x0)*sx, (y1-y0)*sy) + hypot((x2-x1)*sx, (y2-y1)*sy) + hypot((x-x2)*sx, (y-y2)*sy);
+	n = (int)(len / CURVE_PIXELS) + 1;
+	if(n > CURVE_MAX_LINES) n = CURVE_MAX_LINES;
+
+	for(i=1; i<n; i++) {
+		t = (double)i/n;
+		u = 1-t;
+		drawLine(w, u*u*u*x0 + 3*u*u*t*x1 + 3*u*t*t*x2 + t*t*t*x,
+			u*u*u*y0 + 3*u*u*t*y1 + 3*u*t*t*y2 + t*t*t*y, weight);
+	}
+	drawLine(w, x, y, weight);
 }
 
-void lineTo(double x, double y, double weight) {
+static void drawLine(struct window *w, double x, double y, double weight) {
 	int x0, y0, x1, y1, i;
 	//disallow completely black lines
 	Uint8 wt = (Uint8)(weight*245+10);
 
-	x0 = clamp((int)((SIZE-4)*((cursX - xmin) / (xmax - xmin)))+2);
-	y0 = clamp((int)((SIZE-4)*((cursY - ymin) / (ymax - ymin)))+2);
-	x1 = clamp((int)((SIZE-4)*((x - xmin) / (xmax - xmin)))+2);
-	y1 = clamp((int)((SIZE-4)*((y - ymin) / (ymax - ymin)))+2);
+	x0 = clamp((int)((SIZE-4)*((w->cursX - w->xmin) / (w->xmax - w->xmin)))+2);
+	y0 = clamp((int)((SIZE-4)*((w->cursY - w->ymin) / (w->ymax - w->ymin)))+2);
+	x1 = clamp((int)((SIZE-4)*((x - w->xmin) / (w->xmax - w->xmin)))+2);
+	y1 = clamp((int)((SIZE-4)*((y - w->ymin) / (w->ymax - w->ymin)))+2);
 
-	if(flipX) {
+	if(w->flipX) {
 		x0 = SIZE-x0;
 		x1 = SIZE-x1;
 	}
-	if(flipY) {
+	if(w->flipY) {
 		y0 = SIZE-y0;
 		y1 = SIZE-y1;
 	}
-	if(swapXY) {
+	if(w->swapXY) {
 		i = x0;
 		x0 = y0;
 		y0 = i;
@@ -139,41 +276,131 @@ void lineTo(double x, double y, double weight) {
 	}
 
 	//move cursor to end of the new line
-	cursX = x;
-	cursY = y;
-
-	//draw thick lines
-	if(iabs(x1-x0) > iabs(y1-y0)) {
-		//shallow
-		lineTo2(x0, y0, x1, y1, wt);
-		for(i=1; i<=LINEWIDTH/2; i++) {
-			lineTo2(x0, y0-i, x1, y1-i, wt);
-			lineTo2(x0, y0+i, x1, y1+i, wt);
+	w->cursX = x;
+	w->cursY = y;
+
+	thickLine(w, x0, y0, x1, y1, wt);
+}
+
+//a rectangle in rects for each run of tiles along a row with any of flags
+//returns how many, or -1 if they cover enough of the window to do all of it instead
+static int tileRects(const Uint8 *tiles, int flags, SDL_Rect *rects) {
+	int x, y, end, n = 0, count = 0;
+
+	for(y=0; y<TILES; y++) {
+		for(x=0; x<TILES; x=end) {
+			end = x+1;
+			if(!(tiles[y*TILES + x] & flags)) continue;
+			while(end < TILES && (tiles[y*TILES + end] & flags)) end++;
+			//the last row and column may be cut short by the edge of the window
+			rects[n].x = x*TILE;
+			rects[n].y = y*TILE;
+			rects[n].w = (end*TILE < SIZE ? end*TILE : SIZE) - x*TILE;
+			rects[n].h = ((y+1)*TILE < SIZE ? TILE : SIZE - y*TILE);
+			n++;
+			count += end - x;
 		}
-	} else {
-		//steep
-		lineTo2(x0, y0, x1, y1, wt);
-		for(i=1; i<=LINEWIDTH/2; i++) {
-			lineTo2(x0-i, y0, x1-i, y1, wt);
-			lineTo2(x0+i, y0, x1+i, y1, wt);
+	}
+	return count*100 > FULL_TILES*TILES*TILES ? -1 : n;
+}
+
+//the whole window as one rectangle, for when tileRects says -1; returns 1
+static int wholeWindow(SDL_Rect *rects) {
+	rects[0].x = rects[0].y = 0;
+	rects[0].w = rects[0].h = SIZE;
+	return 1;
+}
+
+//copy n rectangles of pixels from one buffer to another, or clear them if from is NULL
+static void copyRects(Uint16 *to, int toPitch, const Uint16 *from, int fromPitch, const SDL_Rect *rects, int n) {
+	int i, y;
+
+	for(i=0; i<n; i++)
+		for(y=rects[i].y; y<rects[i].y+rects[i].h; y++) {
+			if(from) memcpy(to + y*toPitch + rects[i].x, from + y*fromPitch + rects[i].x, rects[i].w * sizeof(Uint16));
+			else memset(to + y*toPitch + rects[i].x, 0, rects[i].w * sizeof(Uint16));
 		}
+}
+
+static void windowFlip(void *st, int clear) {
+	struct window *w = st;
+	int i, n;
+	PROF_BEGIN(tPresent);
+
+	n = tileRects(w->tiles, TILE_NEW | TILE_STALE, w->rects);
+	if(w->buf) {
+		//put what changed aside for windowPresent, on top of anything it hasn't shown yet
+		if(n < 0) n = wholeWindow(w->rects);
+		SDL_LockMutex(w->lock);
+		copyRects(w->ready, SIZE, w->buf, SIZE, w->rects, n);
+		for(i=0; i<TILES*TILES; i++)
+			if(w->tiles[i] & (TILE_NEW | TILE_STALE)) w->readyTiles[i] = 1;
+		SDL_UnlockMutex(w->lock);
+	} else {
+		//refresh what changed on screen from pixel buffer
+		if(n < 0) SDL_UpdateRect(w->screen, 0, 0, 0, 0);
+		else if(n > 0) SDL_UpdateRects(w->screen, n, w->rects);
 	}
+
+	//clear buffer if requested, where anything's been drawn
+	if(clear) {
+		n = tileRects(w->tiles, TILE_PAINTED, w->rects);
+		if(w->buf) {
+			if(n < 0) n = wholeWindow(w->rects);
+			copyRects(w->buf, SIZE, NULL, 0, w->rects, n);
+		} else if(n < 0) SDL_FillRect(w->screen, NULL, 0);
+		else for(i=0; i<n; i++) SDL_FillRect(w->screen, &w->rects[i], 0);
+	}
+	//and the screen now shows what's been cleared, until next time
+	for(i=0; i<TILES*TILES; i++) {
+		if(clear) w->tiles[i] = (w->tiles[i] & TILE_PAINTED) ? TILE_STALE : 0;
+		else w->tiles[i] &= TILE_PAINTED;
+	}
+	PROF_END(tPresent, "window present");
 }
 
-void flip(int clear) {
-	//refresh entire screen from pixel buffer
-	SDL_UpdateRect(screen, 0, 0, 0, 0);
+//from now on draw in a buffer of our own, and leave the screen to windowPresent
+static void windowDeferPresent(void *st) {
+	struct window *w = st;
 
-	//clear buffer if requested
-	if(clear) SDL_FillRect(SDL_GetVideoSurface(), NULL, 0);
+	w->buf = calloc(SIZE*SIZE, sizeof(Uint16));
+	w->ready = calloc(SIZE*SIZE, sizeof(Uint16));
+	w->lock = SDL_CreateMutex();
+	if(w->buf == NULL || w->ready == NULL || w->lock == NULL) {
+		fprintf(stderr, "window: out of memory\n");
+		exit(1);
+	}
 }
 
-void setMode(int mode) {
-	flipX = mode&1;
-	flipY = mode&2;
-	swapXY = mode&4;
+//show the tiles of the newest frame that flip has got ready since last time
+static void windowPresent(void *st) {
+	struct window *w = st;
+	int n;
+
+	SDL_LockMutex(w->lock);
+	n = tileRects(w->readyTiles, 1, w->presentRects);
+	if(n < 0) n = wholeWindow(w->presentRects);
+	if(n > 0 && (!SDL_MUSTLOCK(w->screen) || SDL_LockSurface(w->screen) == 0)) {
+		copyRects(w->screen->pixels, w->screen->pitch/2, w->ready, SIZE, w->presentRects, n);
+		if(SDL_MUSTLOCK(w->screen)) SDL_UnlockSurface(w->screen);
+		SDL_UpdateRects(w->screen, n, w->presentRects);
+		memset(w->readyTiles, 0, sizeof(w->readyTiles));
+	}
+	SDL_UnlockMutex(w->lock);
 }
 
-double getRefreshRate(void) {
-	return 0.0;
+static void windowSetMode(void *st, int mode) {
+	struct window *w = st;
+
+	w->flipX = mode&1;
+	w->flipY = mode&2;
+	w->swapXY = mode&4;
 }
+
+//frames are drawn straight to the window, so there's never a queue or a refresh rate
+const struct gfxBackend windowBackend = {
+	"window", "draw in a window",
+	windowInit, windowDestroy, windowSetScale, windowMoveTo, windowLineTo, windowCubicTo, windowFlip, windowSetMode,
+	NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+	windowDeferPresent, windowPresent
+};
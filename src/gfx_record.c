@@ -0,0 +1,167 @@
+/* Draw call recorder (see gfx_record.h for the file format)
+ *
+ * I'm releasing this code under the WTFPL. You can do whatever you like with
+ * it, though I'd appreciate credit and thanks if you find it useful or fun.
+ * See LICENSE.txt for details.
+ *            -Joe McKenzie / Chupi
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "gfx.h"
+#include "gfx_record.h"
+
+FILE *recFile = NULL;
+
+//current state, kept even when not recording so a recording can start any time
+static double r_xmin=0, r_xmax=1000, r_ymin=0, r_ymax=1000, r_weight=100;
+static int r_mode = 0, r_wrap = 0;
+
+//previous point and weight, for delta coding
+static long lastQX, lastQY;
+static long lastW;
+static Uint32 lastFlip;
+
+static void putVarint(unsigned long n) {
+	while(n >= 0x80) {
+		putc((int)(n & 0x7f) | 0x80, recFile);
+		n >>= 7;
+	}
+	putc((int)n, recFile);
+}
+
+static void putSigned(long n) {
+	//zigzag: 0, -1, 1, -2, 2... become 0, 1, 2, 3, 4...
+	putVarint(n < 0 ? ((unsigned long)(-(n+1)) << 1) | 1 : (unsigned long)n << 1);
+}
+
+static void putDouble(double d) {
+	Uint64 bits;
+	int i;
+
+	//write little endian regardless of what we're running on
+	memcpy(&bits, &d, 8);
+	for(i=0; i<8; i++)
+		putc((int)((bits >> (8*i)) & 0xff), recFile);
+}
+
+static long quantize(double v, double lo, double hi) {
+	if(lo == hi) return 1L << (REC_QBITS-1);	//flat axis: middle, like lineTo does
+	return lround((v-lo)/(hi-lo) * (1L << REC_QBITS));
+}
+
+static void putPoint(double x, double y) {
+	long qx = quantize(x, r_xmin, r_xmax);
+	long qy = quantize(y, r_ymin, r_ymax);
+
+	putSigned(qx - lastQX);
+	putSigned(qy - lastQY);
+	lastQX = qx;
+	lastQY = qy;
+}
+
+static void putScale(void) {
+	putc(OP_SCALE, recFile);
+	putDouble(r_xmin);
+	putDouble(r_xmax);
+	putDouble(r_ymin);
+	putDouble(r_ymax);
+	putDouble(r_weight);
+}
+
+void gfxRecord(const char *filename) {
+	if(recFile != NULL) {
+		fclose(recFile);
+		recFile = NULL;
+	}
+	if(filename == NULL) return;
+
+	recFile = fopen(filename, "wb");
+	if(recFile == NULL) {
+		perror(filename);
+		return;
+	}
+	fwrite(REC_MAGIC, 4, 1, recFile);
+	putc(REC_VERSION, recFile);
+
+	lastQX = lastQY = 0;
+	lastW = -1;
+	lastFlip = SDL_GetTicks();
+
+	putScale();
+	putc(OP_MODE, recFile);
+	putVarint(r_mode);
+	putc(OP_WRAP, recFile);
+	putVarint(r_wrap);
+}
+
+void recMoveTo(double x, double y) {
+	putc(OP_MOVE, recFile);
+	putPoint(x, y);
+}
+
+void recLineTo(double x, double y, double weight) {
+	long w = weight > 0 ? lround(weight * REC_WSCALE) : 0;
+
+	if(w == lastW) {
+		putc(OP_LINE, recFile);
+	} else {
+		putc(OP_LINEW, recFile);
+		putVarint(w);
+		lastW = w;
+	}
+	putPoint(x, y);
+}
+
+void recCubicTo(double x1, double y1, double x2, double y2, double x, double y, double weight) {
+	putc(OP_CUBIC, recFile);
+	putVarint(weight > 0 ? lround(weight * REC_WSCALE) : 0);
+	putPoint(x1, y1);
+	putPoint(x2, y2);
+	putPoint(x, y);
+}
+
+void recBeginObject(int id, double x, double y, double angle) {
+	putc(OP_OBJECT, recFile);
+	putSigned(id);
+	putPoint(x, y);
+	putDouble(angle);
+}
+
+void recEndObject(void) {
+	putc(OP_ENDOBJ, recFile);
+}
+
+void recFlip(int clear) {
+	Uint32 now = SDL_GetTicks();
+
+	putc(clear ? OP_FLIPC : OP_FLIP, recFile);
+	putVarint(now - lastFlip);
+	lastFlip = now;
+}
+
+void recSetMode(int mode) {
+	r_mode = mode;
+	if(recFile == NULL) return;
+	putc(OP_MODE, recFile);
+	putVarint(mode);
+}
+
+void recSetWrap(int wrap) {
+	r_wrap = wrap;
+	if(recFile == NULL) return;
+	putc(OP_WRAP, recFile);
+	putVarint(wrap);
+}
+
+void recSetScale(double xleft, double xright, double ytop, double ybottom, double weight) {
+	r_xmin = xleft;
+	r_xmax = xright;
+	r_ymin = ytop;
+	r_ymax = ybottom;
+	r_weight = weight;
+	if(recFile == NULL) return;
+	putScale();
+}
@@ -0,0 +1,92 @@
+/* Recording of the draw call stream to a compact binary file
+ *
+ * Every moveTo, lineTo, cubicTo, flip, setMode, setScale, setWrap, beginObject
+ * and endObject call on the default context passes through here (quadTo, arcTo and circle arrive as
+ * cubicTo). While a recording is active (see gfxRecord in gfx.h), the
+ * calls are appended to a file that the replay program can play back through
+ * either backend as fast as it will go.
+ *
+ * File format: the 4 bytes "VREC", a version byte, then a stream of ops. Each
+ * op is 1 opcode byte followed by its arguments. Numbers are LEB128 varints
+ * (7 bits per byte, low bits first, high bit set if more bytes follow). Signed
+ * numbers are zigzag encoded first, so small negative numbers stay small.
+ *
+ * Coordinates are fixed point fractions of the screen set by the last OP_SCALE:
+ * 0 is the left/top edge and 1<<REC_QBITS is the right/bottom edge. That's a
+ * quarter of the scope's 16-bit resolution, whatever units the program uses.
+ * Each point is stored as the difference from the previous point.
+ *
+ *    OP_MOVE   dx dy      moveTo
+ *    OP_LINE   dx dy      lineTo with the same weight as the last OP_LINEW
+ *    OP_LINEW  w dx dy    lineTo with a new weight, w = weight*REC_WSCALE
+ *    OP_CUBIC  w dx1 dy1 dx2 dy2 dx dy
+ *                         cubicTo, each point relative to the one before;
+ *                         w doesn't change the weight for OP_LINE
+ *    OP_FLIP   ms         flip(0), ms = milliseconds since the previous flip
+ *    OP_FLIPC  ms         flip(1)
+ *    OP_MODE   mode       setMode
+ *    OP_SCALE  5 doubles  setScale, as raw little endian IEEE 754 doubles
+ *    OP_WRAP   enable     setWrap
+ *    OP_OBJECT id dx dy angle
+ *                         beginObject; id is signed, (dx,dy) is a point like
+ *                         the others, and angle is a raw double like OP_SCALE's
+ *    OP_ENDOBJ            endObject
+ *
+ * A recording always starts with OP_SCALE, OP_MODE and OP_WRAP for whatever was set
+ * when it started.
+ *
+ * I'm releasing this code under the WTFPL. You can do whatever you like with
+ * it, though I'd appreciate credit and thanks if you find it useful or fun.
+ * See LICENSE.txt for details.
+ *            -Joe McKenzie / Chupi
+ */
+
+#ifndef __GFX_RECORD_H__
+#define __GFX_RECORD_H__
+
+#include <stdio.h>
+
+#define REC_MAGIC "VREC"
+#define REC_VERSION 4	//3 is the same without OP_OBJECT/OP_ENDOBJ, 2 without OP_WRAP either, 1 without OP_CUBIC
+
+#define REC_QBITS 18	//fraction bits for coordinates
+#define REC_WSCALE 256	//fixed point scale for weights
+
+enum {
+	OP_MOVE = 1,
+	OP_LINE,
+	OP_LINEW,
+	OP_FLIP,
+	OP_FLIPC,
+	OP_MODE,
+	OP_SCALE,
+	OP_CUBIC,
+	OP_WRAP,
+	OP_OBJECT,
+	OP_ENDOBJ,
+};
+
+//file being recorded to, NULL if not recording
+extern FILE *recFile;
+
+//called by the backends before they do the real work
+//use the macros for the frequent calls so it's just a pointer check when not recording
+//recSetMode, recSetScale and recSetWrap must always be called, so a new recording knows the current state
+extern void recMoveTo(double x, double y);
+extern void recLineTo(double x, double y, double weight);
+extern void recCubicTo(double x1, double y1, double x2, double y2, double x, double y, double weight);
+extern void recFlip(int clear);
+extern void recSetMode(int mode);
+extern void recSetScale(double xleft, double xright, double ytop, double ybottom, double weight);
+extern void recSetWrap(int wrap);
+extern void recBeginObject(int id, double x, double y, double angle);
+extern void recEndObject(void);
+
+#define REC_MOVETO(x, y) do { if(recFile) recMoveTo(x, y); } while(0)
+#define REC_LINETO(x, y, w) do { if(recFile) recLineTo(x, y, w); } while(0)
+#define REC_CUBICTO(x1, y1, x2, y2, x, y, w) do { if(recFile) recCubicTo(x1, y1, x2, y2, x, y, w); } while(0)
+#define REC_FLIP(clear) do { if(recFile) recFlip(clear); } while(0)
+#define REC_BEGINOBJECT(id, x, y, a) do { if(recFile) recBeginObject(id, x, y, a); } while(0)
+#define REC_ENDOBJECT() do { if(recFile) recEndObject(); } while(0)
+
+#endif
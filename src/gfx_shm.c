@@ -0,0 +1,149 @@
+/* Producer side of the shared memory frame ring (see gfx_shm.h)
+ *
+ * I'm releasing this code under the WTFPL. You can do whatever you like with
+ * it, though I'd appreciate credit and thanks if you find it useful or fun.
+ * See LICENSE.txt for details.
+ *            -Joe McKenzie / Chupi
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include "gfx_shm.h"
+
+#ifdef _WIN32
+//no POSIX shared memory here; the shm backend just refuses to start
+
+struct shm_ring *shmOpen(const char *name, int freq) {
+	fprintf(stderr, "Shared memory output isn't supported on Windows\n");
+	exit(1);
+}
+
+int16_t *shmBeginFrame(struct shm_ring *r, int n) {
+	return NULL;
+}
+
+void shmEndFrame(struct shm_ring *r) {
+}
+
+void shmClose(struct shm_ring *r) {
+}
+
+#else
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+struct shm_ring {
+	struct shm_header *hdr;
+	struct shm_slot *writing;	//slot between shmBeginFrame and shmEndFrame
+	uint32_t lastSeq;
+	char name[256];
+	struct shm_ring *nextOpen;	//list of open rings, for cleaning up at exit
+};
+
+static struct shm_ring *openRings = NULL;
+
+//remove the objects when the game exits, so consumers can tell they're gone
+static void shmCleanup(void) {
+	while(openRings != NULL) shmClose(openRings);
+}
+
+struct shm_ring *shmOpen(const char *name, int freq) {
+	size_t size = SHM_TOTAL_BYTES(SHM_SLOTS, SHM_SLOT_SAMPLES);
+	struct shm_ring *r;
+	struct shm_header *hdr;
+	int fd, i;
+
+	if(name == NULL) name = getenv("ASTEROIDS_SHM");
+	if(name == NULL || !*name) name = SHM_DEFAULT_NAME;
+	r = calloc(1, sizeof(struct shm_ring));
+	if(r == NULL) {
+		fprintf(stderr, "shmOpen: out of memory\n");
+		exit(1);
+	}
+	snprintf(r->name, sizeof(r->name), "%s", name);
+
+	fd = shm_open(r->name, O_RDWR|O_CREAT, 0644);
+	if(fd < 0) {
+		perror("Couldn't open shared memory");
+		exit(1);
+	}
+	if(ftruncate(fd, size) < 0) {
+		perror("Couldn't size shared memory");
+		exit(1);
+	}
+	hdr = mmap(NULL, size, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if(hdr == MAP_FAILED) {
+		perror("Couldn't map shared memory");
+		exit(1);
+	}
+	r->hdr = hdr;
+
+	//mark the ring invalid while we set it up, in case a consumer is already watching
+	hdr->magic = 0;
+	__sync_synchronize();
+	hdr->version = SHM_VERSION;
+	hdr->sampleRate = freq;
+	hdr->channels = 2;
+	hdr->nslots = SHM_SLOTS;
+	hdr->slotSamples = SHM_SLOT_SAMPLES;
+	hdr->seq = 0;
+	hdr->reserved = 0;
+	for(i=0; i<SHM_SLOTS; i++) {
+		SHM_SLOT(hdr, i)->seq = 0;
+		SHM_SLOT(hdr, i)->n = 0;
+	}
+	__sync_synchronize();
+	hdr->magic = SHM_MAGIC;
+
+	if(openRings == NULL) atexit(shmCleanup);
+	r->nextOpen = openRings;
+	openRings = r;
+	fprintf(stderr, "Publishing frames to shared memory %s (%d slots of %d samples)\n", r->name, SHM_SLOTS, SHM_SLOT_SAMPLES);
+	return r;
+}
+
+int16_t *shmBeginFrame(struct shm_ring *r, int n) {
+	if(n > (int)r->hdr->slotSamples) {
+		fprintf(stderr, "shmBeginFrame: frame of %d samples doesn't fit in a %d sample slot, skipped\n", n, r->hdr->slotSamples);
+		return NULL;
+	}
+
+	if(++r->lastSeq == 0) r->lastSeq = 1;	//0 means "nothing here", skip it if we ever wrap
+	r->writing = SHM_SLOT(r->hdr, r->lastSeq % r->hdr->nslots);
+	r->writing->seq = 0;
+	__sync_synchronize();
+	r->writing->n = n;
+	return SHM_SAMPLES(r->writing);
+}
+
+void shmEndFrame(struct shm_ring *r) {
+	if(r->writing == NULL) return;
+	//samples must be visible before the sequence numbers say they're there
+	__sync_synchronize();
+	r->writing->seq = r->lastSeq;
+	__sync_synchronize();
+	r->hdr->seq = r->lastSeq;
+	r->writing = NULL;
+}
+
+void shmClose(struct shm_ring *r) {
+	struct shm_ring **p;
+
+	for(p = &openRings; *p != NULL; p = &(*p)->nextOpen) {
+		if(*p == r) {
+			*p = r->nextOpen;
+			break;
+		}
+	}
+	r->hdr->magic = 0;
+	munmap(r->hdr, SHM_TOTAL_BYTES(r->hdr->nslots, r->hdr->slotSamples));
+	shm_unlink(r->name);
+	free(r);
+}
+
+#endif
@@ -0,0 +1,94 @@
+/* Shared memory ring buffer for handing rendered frames to another process
+ *
+ * The shm backend (-backend shm) doesn't open the sound card at all. Instead
+ * every frame that flip renders is written into a POSIX shared memory object,
+ * where some other local program (your own DAC driver, a recorder, or the
+ * shm-consumer example) can read it in place without copying. Not available
+ * on Windows.
+ *
+ * Layout of the shared memory object:
+ *    struct shm_header
+ *    nslots * (struct shm_slot followed by slotSamples L/R pairs of int16_t)
+ *
+ * Samples are in the same format gfx.c feeds SDL: interleaved, native-endian
+ * signed 16-bit, left (vertical) first, then right (horizontal).
+ *
+ * Frame N goes in slot N % nslots. While the producer is writing a slot, that
+ * slot's seq is 0. When it's done, it sets the slot's seq to N, and then sets
+ * the header's seq to N. A reader looks at the header's seq to find the newest
+ * frame, uses the samples right where they are, and checks the slot's seq
+ * again afterwards. If it changed, the producer lapped the reader and the
+ * samples it just used may be torn.
+ *
+ * This file is shared by both sides, so it only uses standard C types.
+ *
+ * I'm releasing this code under the WTFPL. You can do whatever you like with
+ * it, though I'd appreciate credit and thanks if you find it useful or fun.
+ * See LICENSE.txt for details.
+ *            -Joe McKenzie / Chupi
+ */
+
+#ifndef __GFX_SHM_H__
+#define __GFX_SHM_H__
+
+#include <stdint.h>
+
+#define SHM_MAGIC 0x4f435356	//"VSCO" in memory on little endian machines
+#define SHM_VERSION 1
+
+//default name of the shared memory object; override with ASTEROIDS_SHM env var
+#define SHM_DEFAULT_NAME "/asteroids-scope"
+
+//number of frames kept in the ring and the biggest frame a slot can hold
+//65536 L/R pairs is about 1.5 seconds at 44100 Hz, way slower than a usable picture
+#define SHM_SLOTS 4
+#define SHM_SLOT_SAMPLES 65536
+
+struct shm_header {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t sampleRate;
+	uint32_t channels;	//always 2
+	uint32_t nslots;
+	uint32_t slotSamples;	//capacity of each slot, in L/R pairs
+	volatile uint32_t seq;	//sequence number of newest complete frame, 0 if none yet
+	uint32_t reserved;
+};
+
+struct shm_slot {
+	volatile uint32_t seq;	//frame sequence number stored here, 0 while being written
+	uint32_t n;	//number of L/R pairs in this frame
+};
+
+//total size of a shared memory object with the given geometry
+#define SHM_SLOT_BYTES(slotSamples) (sizeof(struct shm_slot) + (slotSamples)*2*sizeof(int16_t))
+#define SHM_TOTAL_BYTES(nslots, slotSamples) (sizeof(struct shm_header) + (nslots)*SHM_SLOT_BYTES(slotSamples))
+
+//find slot i and its samples in a mapped object
+#define SHM_SLOT(hdr, i) ((struct shm_slot *)((char *)((hdr)+1) + (i)*SHM_SLOT_BYTES((hdr)->slotSamples)))
+#define SHM_SAMPLES(slot) ((int16_t *)((slot)+1))
+
+/* Producer side, implemented in gfx_shm.c
+ * A process can publish several rings, each under its own name.            */
+
+struct shm_ring;
+
+/* shmOpen: create (or reuse) the shared memory object and map it
+ *   name: object name, like "/asteroids-scope". NULL uses ASTEROIDS_SHM from
+ *     the environment, or SHM_DEFAULT_NAME if that isn't set.
+ *   freq: sample rate to advertise in the header
+ *   On failure, prints an error and exits, like gfxInit does.               */
+extern struct shm_ring *shmOpen(const char *name, int freq);
+
+/* shmBeginFrame: get a slot to render a frame of n L/R pairs into
+ *   Returns NULL if the frame doesn't fit in a slot; that frame is skipped.  */
+extern int16_t *shmBeginFrame(struct shm_ring *r, int n);
+
+/* shmEndFrame: publish the frame started by shmBeginFrame                   */
+extern void shmEndFrame(struct shm_ring *r);
+
+/* shmClose: unmap and remove the object, telling consumers it's gone. Rings
+ *   still open when the program exits are closed automatically.             */
+extern void shmClose(struct shm_ring *r);
+
+#endif
@@ -0,0 +1,439 @@
+/* Tee backend: one stream of draw calls, drawn by two backends at once
+ *
+ * Selected with "tee", which means "tee:scope+window", or "tee:a+b" for any
+ * other two backends, each with its own ":arg" if it takes one. Handy for
+ * watching the scope picture on the monitor too, without running the game
+ * twice. Each backend gets its own instance, so any two will do, as long as
+ * there's only one scope and one window between them (tee:file+null works).
+ *
+ * Each backend gets its own thread, so a slow one (the window's rasterizer)
+ * never holds up the other (the scope's sound card). Draw calls, setScale,
+ * setMode and setMotion are saved into a snapshot of the frame, and flip hands the finished
+ * snapshot to both threads. Snapshots are never changed once handed over, so
+ * both threads can read the same one. If a thread is still busy with an older
+ * frame, that frame is skipped and it moves on to the newest one.
+ *
+ * So a skipped frame can't lose anything, each snapshot holds the whole
+ * picture: it starts with the scale and mode in force, and after flip(0) the
+ * next snapshot starts as a copy of the last one. The threads always draw a
+ * snapshot from scratch and flip(1).
+ *
+ * Both backends are initialized on the main thread, so the window gets its
+ * video mode where SDL expects it. SDL's video functions aren't safe from any
+ * other thread, so the window's thread only draws into a buffer of its own
+ * (see deferPresent in gfx_backend.h), and each flip on the main thread shows
+ * the newest frame it has finished.
+ *
+ * I'm releasing this code under the WTFPL. You can do whatever you like with
+ * it, though I'd appreciate credit and thanks if you find it useful or fun.
+ * See LICENSE.txt for details.
+ *            -Joe McKenzie / Chupi
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "gfx.h"
+#include "gfx_backend.h"
+#include "prof.h"
+
+#define TEE_DEFAULT "scope+window"
+
+enum { CMD_MOVE, CMD_LINE, CMD_CUBIC, CMD_SCALE, CMD_MODE, CMD_MOTION };
+
+struct cmd {
+	int op;
+	double a[7];	//the call's arguments in order; a[0] is the mode for MODE, and MOTION has a[5] set if it isn't NULL
+};
+
+struct snapshot {
+	int refs;	//threads still to draw it, protected by the tee's lock
+	int n, max;
+	struct cmd *cmds;
+};
+
+struct tee;
+
+struct worker {
+	struct tee *t;
+	const struct gfxBackend *be;
+	void *st;	//the backend instance's own state
+	char arg[256];
+	SDL_Thread *thread;
+	struct snapshot *next;	//newest snapshot it hasn't started on yet
+	long skipped;
+};
+
+struct tee {
+	struct worker workers[2];
+	SDL_mutex *lock;
+	SDL_cond *ready;
+	int quitting;
+
+	//snapshot being built by the draw calls
+	struct snapshot *building;
+
+	//current state, for starting each snapshot
+	double scale[5];
+	int mode;
+};
+
+static struct snapshot *newSnapshot(int max) {
+	struct snapshot *s = malloc(sizeof(struct snapshot));
+
+	if(max < 64) max = 64;
+	s->refs = 0;
+	s->n = 0;
+	s->max = max;
+	s->cmds = malloc(max * sizeof(struct cmd));
+	if(s->cmds == NULL) {
+		fprintf(stderr, "tee: out of memory\n");
+		exit(1);
+	}
+	return s;
+}
+
+static void freeSnapshot(struct snapshot *s) {
+	free(s->cmds);
+	free(s);
+}
+
+static struct cmd *addCmd(struct tee *t, int op) {
+	struct snapshot *b = t->building;
+	struct cmd *c;
+
+	if(b->n == b->max) {
+		b->max *= 2;
+		b->cmds = realloc(b->cmds, b->max * sizeof(struct cmd));
+		if(b->cmds == NULL) {
+			fprintf(stderr, "tee: out of memory\n");
+			exit(1);
+		}
+	}
+	c = &b->cmds[b->n++];
+	c->op = op;
+	return c;
+}
+
+//start an empty snapshot with the current scale and mode
+static void startSnapshot(struct tee *t) {
+	struct cmd *c;
+
+	t->building = newSnapshot(0);
+	c = addCmd(t, CMD_SCALE);
+	memcpy(c->a, t->scale, sizeof(t->scale));
+	c = addCmd(t, CMD_MODE);
+	c->a[0] = t->mode;
+}
+
+//call with the tee's lock held
+static void release(struct snapshot *s) {
+	if(--s->refs == 0) freeSnapshot(s);
+}
+
+static int workerThread(void *data) {
+	struct worker *w = data;
+	struct tee *t = w->t;
+	struct snapshot *s;
+	struct cmd *c;
+	int i;
+
+	PROF_THREAD(w->be->name);
+	while(1) {
+		SDL_LockMutex(t->lock);
+		while(w->next == NULL && !t->quitting)
+			SDL_CondWait(t->ready, t->lock);
+		//finish the last frame before quitting, so a file gets it too
+		if(w->next == NULL) {
+			SDL_UnlockMutex(t->lock);
+			return 0;
+		}
+		s = w->next;
+		w->next = NULL;
+		SDL_UnlockMutex(t->lock);
+
+		PROF_BEGIN(tDraw);
+		for(i=0; i<s->n; i++) {
+			c = &s->cmds[i];
+			switch(c->op) {
+			case CMD_MOVE:
+				w->be->moveTo(w->st, c->a[0], c->a[1]);
+				break;
+			case CMD_LINE:
+				w->be->lineTo(w->st, c->a[0], c->a[1], c->a[2]);
+				break;
+			case CMD_CUBIC:
+				w->be->cubicTo(w->st, c->a[0], c->a[1], c->a[2], c->a[3], c->a[4], c->a[5], c->a[6]);
+				break;
+			case CMD_SCALE:
+				w->be->setScale(w->st, c->a[0], c->a[1], c->a[2], c->a[3], c->a[4]);
+				break;
+			case CMD_MODE:
+				w->be->setMode(w->st, (int)c->a[0]);
+				break;
+			case CMD_MOTION:
+				if(w->be->setMotion) w->be->setMotion(w->st, c->a[5] ? c->a : NULL);
+				break;
+			}
+		}
+		w->be->flip(w->st, 1);
+		PROF_END(tDraw, "tee draw");
+
+		SDL_LockMutex(t->lock);
+		release(s);
+		SDL_UnlockMutex(t->lock);
+	}
+}
+
+static void *teeInit(int freq, int buffer, const char *arg) {
+	struct tee *t = calloc(1, sizeof(struct tee));
+	struct worker *w;
+	const char *part, *plus, *colon;
+	int i, len;
+
+	if(arg == NULL) arg = TEE_DEFAULT;
+	plus = strchr(arg, '+');
+	if(plus == NULL) {
+		fprintf(stderr, "tee: expected two backends like %s, got %s\n", TEE_DEFAULT, arg);
+		exit(1);
+	}
+
+	//find both backends and their arguments
+	for(i=0; i<2; i++) {
+		w = &t->workers[i];
+		part = i ? plus+1 : arg;
+		len = i ? (int)strlen(part) : plus - arg;
+		colon = memchr(part, ':', len);
+		w->t = t;
+		w->be = gfxFindBackend(part, colon ? colon - part : len);
+		if(w->be == &teeBackend) {
+			fprintf(stderr, "tee: can't tee into a tee\n");
+			exit(1);
+		}
+		if(colon) snprintf(w->arg, sizeof(w->arg), "%.*s", len - (int)(colon-part) - 1, colon+1);
+	}
+
+	//both are initialized here on the main thread, then drawn from their own
+	for(i=0; i<2; i++) {
+		w = &t->workers[i];
+		w->st = w->be->init(freq, buffer, w->arg[0] ? w->arg : NULL);
+		if(w->be->deferPresent) w->be->deferPresent(w->st);
+	}
+
+	t->scale[1] = 1000;
+	t->scale[3] = 1000;
+	t->scale[4] = 100;
+	t->lock = SDL_CreateMutex();
+	t->ready = SDL_CreateCond();
+	startSnapshot(t);
+	for(i=0; i<2; i++) {
+		w = &t->workers[i];
+		w->thread = SDL_CreateThread(workerThread, w);
+		if(w->thread == NULL) {
+			fprintf(stderr, "tee: couldn't start thread: %s\n", SDL_GetError());
+			exit(1);
+		}
+	}
+	return t;
+}
+
+//lets the threads finish drawing, then stops both backends
+static void teeDestroy(void *st) {
+	struct tee *t = st;
+	struct worker *w;
+	int i;
+
+	SDL_LockMutex(t->lock);
+	t->quitting = 1;
+	SDL_CondBroadcast(t->ready);
+	SDL_UnlockMutex(t->lock);
+
+	for(i=0; i<2; i++) {
+		w = &t->workers[i];
+		SDL_WaitThread(w->thread, NULL);
+		if(w->be->present) w->be->present(w->st);
+		if(w->skipped)
+			fprintf(stderr, "tee: %s skipped %ld frames to keep up\n", w->be->name, w->skipped);
+		w->be->destroy(w->st);
+	}
+	freeSnapshot(t->building);
+	SDL_DestroyCond(t->ready);
+	SDL_DestroyMutex(t->lock);
+	free(t);
+}
+
+static void teeSetScale(void *st, double xleft, double xright, double ytop, double ybottom, double weight) {
+	struct tee *t = st;
+
+	t->scale[0] = xleft;
+	t->scale[1] = xright;
+	t->scale[2] = ytop;
+	t->scale[3] = ybottom;
+	t->scale[4] = weight;
+	memcpy(addCmd(t, CMD_SCALE)->a, t->scale, sizeof(t->scale));
+}
+
+static void teeMoveTo(void *st, double x, double y) {
+	struct cmd *c = addCmd(st, CMD_MOVE);
+
+	c->a[0] = x;
+	c->a[1] = y;
+}
+
+static void teeLineTo(void *st, double x, double y, double weight) {
+	struct cmd *c = addCmd(st, CMD_LINE);
+
+	c->a[0] = x;
+	c->a[1] = y;
+	c->a[2] = weight;
+}
+
+static void teeCubicTo(void *st, double x1, double y1, double x2, double y2, double x, double y, double weight) {
+	struct cmd *c = addCmd(st, CMD_CUBIC);
+
+	c->a[0] = x1;
+	c->a[1] = y1;
+	c->a[2] = x2;
+	c->a[3] = y2;
+	c->a[4] = x;
+	c->a[5] = y;
+	c->a[6] = weight;
+}
+
+static void teeSetMotion(void *st, const double *motion) {
+	struct cmd *c = addCmd(st, CMD_MOTION);
+
+	if(motion) memcpy(c->a, motion, 5*sizeof(double));
+	c->a[5] = motion != NULL;
+}
+
+static void teeFlip(void *st, int clear) {
+	struct tee *t = st;
+	struct snapshot *s = t->building;
+	int i;
+
+	//next frame starts empty, or with everything drawn so far
+	//(copied now, since s may be freed as soon as the threads have it)
+	if(clear) {
+		startSnapshot(t);
+	} else {
+		t->building = newSnapshot(s->n);
+		memcpy(t->building->cmds, s->cmds, s->n * sizeof(struct cmd));
+		t->building->n = s->n;
+	}
+
+	//hand it to both threads, replacing anything they haven't started on yet
+	SDL_LockMutex(t->lock);
+	s->refs = 2;
+	for(i=0; i<2; i++) {
+		if(t->workers[i].next) {
+			release(t->workers[i].next);
+			t->workers[i].skipped++;
+		}
+		t->workers[i].next = s;
+	}
+	SDL_CondBroadcast(t->ready);
+	SDL_UnlockMutex(t->lock);
+
+	//and show what they've finished, here on the main thread
+	for(i=0; i<2; i++)
+		if(t->workers[i].be->present) t->workers[i].be->present(t->workers[i].st);
+}
+
+static void teeSetMode(void *st, int mode) {
+	struct tee *t = st;
+
+	t->mode = mode;
+	addCmd(t, CMD_MODE)->a[0] = mode;
+}
+
+//queue settings and stats come from whichever backend has them (the scope, usually)
+
+static void teeSetFrameQueue(void *st, int depth, int policy) {
+	struct tee *t = st;
+	int i;
+
+	for(i=0; i<2; i++)
+		if(t->workers[i].be->setFrameQueue) t->workers[i].be->setFrameQueue(t->workers[i].st, depth, policy);
+}
+
+static void teeSetMidFrameSwitch(void *st, int enable) {
+	struct tee *t = st;
+	int i;
+
+	for(i=0; i<2; i++)
+		if(t->workers[i].be->setMidFrameSwitch) t->workers[i].be->setMidFrameSwitch(t->workers[i].st, enable);
+}
+
+static int teeGetQueuedFrames(void *st) {
+	struct tee *t = st;
+	int i;
+
+	for(i=0; i<2; i++)
+		if(t->workers[i].be->getQueuedFrames) return t->workers[i].be->getQueuedFrames(t->workers[i].st);
+	return 0;
+}
+
+static long teeGetDroppedFrames(void *st) {
+	struct tee *t = st;
+	int i;
+
+	for(i=0; i<2; i++)
+		if(t->workers[i].be->getDroppedFrames) return t->workers[i].be->getDroppedFrames(t->workers[i].st);
+	return 0;
+}
+
+static double teeGetRefreshRate(void *st) {
+	struct tee *t = st;
+	int i;
+
+	for(i=0; i<2; i++)
+		if(t->workers[i].be->getRefreshRate) return t->workers[i].be->getRefreshRate(t->workers[i].st);
+	return 0.0;
+}
+
+static void teeSetSimplify(void *st, int enable) {
+	struct tee *t = st;
+	int i;
+
+	for(i=0; i<2; i++)
+		if(t->workers[i].be->setSimplify) t->workers[i].be->setSimplify(t->workers[i].st, enable);
+}
+
+static void teeSetStabilize(void *st, int interval) {
+	struct tee *t = st;
+	int i;
+
+	for(i=0; i<2; i++)
+		if(t->workers[i].be->setStabilize) t->workers[i].be->setStabilize(t->workers[i].st, interval);
+}
+
+//only one of them can write the heat map, and it's the first with stats to show for it
+static void teeGetBeamStats(void *st, struct beamStats *bs) {
+	struct tee *t = st;
+	int i;
+
+	for(i=0; i<2; i++)
+		if(t->workers[i].be->getBeamStats) {
+			t->workers[i].be->getBeamStats(t->workers[i].st, bs);
+			return;
+		}
+}
+
+static void teeSetHeatMap(void *st, const char *filename) {
+	struct tee *t = st;
+	int i;
+
+	for(i=0; i<2; i++)
+		if(t->workers[i].be->setHeatMap) {
+			t->workers[i].be->setHeatMap(t->workers[i].st, filename);
+			return;
+		}
+}
+
+const struct gfxBackend teeBackend = {
+	"tee", "two backends at once, each on its own thread (tee:scope+window)",
+	teeInit, teeDestroy, teeSetScale, teeMoveTo, teeLineTo, teeCubicTo, teeFlip, teeSetMode,
+	teeSetFrameQueue, teeSetMidFrameSwitch, teeGetQueuedFrames, teeGetDroppedFrames, teeGetRefreshRate, teeSetSimplify, teeSetStabilize, teeSetMotion,
+	teeGetBeamStats, teeSetHeatMap
+};
@@ -0,0 +1,72 @@
+/* Keyboard input as it happens, with timestamps (see input.h)
+ *
+ * I'm releasing this code under the WTFPL. You can do whatever you like with
+ * it, though I'd appreciate credit and thanks if you find it useful or fun.
+ * See LICENSE.txt for details.
+ *            -Joe McKenzie / Chupi
+ */
+
+#include <stdio.h>
+#include "input.h"
+#include "prof.h"
+
+//the ring: the filter writes at head, the game reads at tail, and each only
+//moves its own; both just count up and wrap around the ring
+static struct inputEvent queue[INPUT_QUEUE];
+static volatile Uint32 head = 0, tail = 0;
+
+static int threaded = 0;
+
+//runs on whichever thread SDL reads events on
+static int SDLCALL filter(const SDL_Event *ev) {
+	struct inputEvent *q;
+
+	if(ev->type != SDL_KEYDOWN && ev->type != SDL_KEYUP && ev->type != SDL_QUIT)
+		return 1;	//SDL can keep it, for inputPoll to throw away
+	if(head - tail >= INPUT_QUEUE) {
+		fprintf(stderr, "input: too many events at once, dropped one\n");
+		return 0;
+	}
+	q = &queue[head % INPUT_QUEUE];
+	q->time = profNow();
+	q->type = ev->type;
+	q->key = ev->type == SDL_QUIT ? SDLK_UNKNOWN : ev->key.keysym.sym;
+	__sync_synchronize();	//the event is all there before the game can see it
+	head++;
+	return 0;
+}
+
+void inputInit(int thread) {
+	threaded = thread;
+	SDL_SetEventFilter(filter);
+}
+
+int inputPoll(struct inputEvent *ev, Uint64 before) {
+	SDL_Event sev;
+	struct inputEvent *q;
+
+	//without the event thread this is what reads events (and runs the filter)
+	while(SDL_PollEvent(&sev));
+
+	if(tail == head) return 0;
+	__sync_synchronize();	//don't read the event before the head that says it's there
+	q = &queue[tail % INPUT_QUEUE];
+	if(q->time > before) return 0;
+	*ev = *q;
+	__sync_synchronize();	//done with the slot before the filter can reuse it
+	tail++;
+	return 1;
+}
+
+void inputWait(Uint32 ms) {
+	Uint32 start = SDL_GetTicks();
+
+	if(threaded) {
+		SDL_Delay(ms);
+		return;
+	}
+	while(SDL_GetTicks() - start < ms) {
+		SDL_PumpEvents();
+		SDL_Delay(1);
+	}
+}
@@ -0,0 +1,46 @@
+/* Keyboard input as it happens, with timestamps
+ *
+ * The game only looks at input once a tick, but it wants to know when each
+ * key went down and came up in between. That way holding a key for part of a
+ * tick counts for just that part, and a quick tap inside one tick isn't lost.
+ *
+ * Key and quit events are caught by an SDL event filter as soon as SDL reads
+ * them from the system, stamped with profNow(), and put on a lock-free ring
+ * with one writer and one reader, for the game to take in order. Where SDL can
+ * read events on a thread of its own (SDL_INIT_EVENTTHREAD, which X11 can do),
+ * that goes on all the time, whatever the game is busy with. Elsewhere SDL has
+ * to read them on the main thread, so inputWait does it every millisecond
+ * while the game sleeps between ticks.
+ *
+ * I'm releasing this code under the WTFPL. You can do whatever you like with
+ * it, though I'd appreciate credit and thanks if you find it useful or fun.
+ * See LICENSE.txt for details.
+ *            -Joe McKenzie / Chupi
+ */
+
+#ifndef __INPUT_H__
+#define __INPUT_H__
+
+#include "SDL/SDL.h"
+
+#define INPUT_QUEUE 256	//events that can wait to be taken; must be a power of 2
+
+struct inputEvent {
+	Uint64 time;	//profNow() when SDL read it
+	Uint8 type;	//SDL_KEYDOWN, SDL_KEYUP or SDL_QUIT
+	SDLKey key;
+};
+
+/* inputInit: start catching events, after SDL_Init and SDL_SetVideoMode.
+ *   threaded: whether SDL_Init was given SDL_INIT_EVENTTHREAD and managed it */
+extern void inputInit(int threaded);
+
+/* inputPoll: take the oldest event that happened no later than before (a
+ *   profNow() time). Returns 0 if there isn't one. Anything else SDL queued,
+ *   like mouse movement, is thrown away.                                     */
+extern int inputPoll(struct inputEvent *ev, Uint64 before);
+
+/* inputWait: sleep for ms milliseconds, reading input as it comes in        */
+extern void inputWait(Uint32 ms);
+
+#endif
@@ -14,31 +14,21 @@
 #include <time.h>
 #include <math.h>
 #include "gfx.h"
-#include "asteroids_objects.h"
-
-#define PI 3.14159265358979323846
-
-//easily-changed game parameters
-#define SAFE_ZONE 150	//radius of safe zone around player where new asteroids won't appear
-#define DRAG 0.25	//slowdown rate of player ship
-#define THRUST 1.0	//player ship thruster power
-#define SPIN (PI/16)	//player ship spin rate
-#define MAX_ROIDS 32	//maximum asteroids on screen at once
-#define INIT_ROIDS 4	//number of asteroids to generate initially
-#define ROID_SPEED 3	//maximum speed for a big asteroid - smaller ones may move faster
-#define MAX_BULLETS 5	//maximum bullets on screen
-#define BULLET_SPEED 15.0	//bullet flight speed
-#define BULLET_RANGE 500	//the screen is 1000 wide and 1000 high
-#define RAPIDFIRE_ENABLE 1	//allow rapidfire by holding space?
-#define RAPIDFIRE_DELAY 5	//frames between rapidfire shots
-#define ROID_RESPAWN_THRESHOLD 5	//make new asteroids when there are fewer than this
-#define ROID_RESPAWN_DELAY 40	//min frames between asteroid respawns (currently 20 frames/sec)
-#define ROID_RESPAWN_RATE 0.6	//probability an asteroid will respawn after ROID_RESPAWN_DELAY
-#define MAX_FRAGMENTS 4	//params for the debris that appears when you die
-#define FRAGMENT_MIN_AGE 15
-#define FRAGMENT_MAX_AGE 25
+#include "asteroids_models.h"
+#include "vmodel.h"
+#include "vlod.h"
+#include "vcache.h"
+#include "vfont.h"
+#include "draw.h"
+#include "settings.h"
+#include "input.h"
+#include "prof.h"
+
+//ids are for interpolating (see beginObject in gfx.h): each new thing gets a new one
+#define SHIP_ID 0
 
 struct roid {
+	int id;
 	int model;
 	int split;
 	double angle, spin;
@@ -47,6 +37,7 @@ struct roid {
 };
 
 struct bullet {
+	int id;
 	double posX, posY;
 	double spdX, spdY;
 	double angle;
@@ -54,6 +45,7 @@ struct bullet {
 };
 
 struct fragment {
+	int id;
 	double posX, posY;
 	double spdX, spdY;
 	double angle;
@@ -62,12 +54,17 @@ struct fragment {
 };
 
 //initialize SDL and the graphics library
-void sys_initialize(void) {
+void sys_initialize(int buffer) {
 	SDL_Surface *screen;
-
-	if (SDL_Init(SDL_INIT_VIDEO) != 0) {
-		printf("Unable to initialize SDL: %s\n", SDL_GetError());
-		exit(1);
+	int threaded = 1;
+
+	//read input on a thread of its own, where SDL can (see input.h)
+	if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_EVENTTHREAD) != 0) {
+		threaded = 0;
+		if (SDL_Init(SDL_INIT_VIDEO) != 0) {
+			printf("Unable to initialize SDL: %s\n", SDL_GetError());
+			exit(1);
+		}
 	}
 
 	atexit(SDL_Quit);
@@ -77,8 +74,9 @@ void sys_initialize(void) {
 		printf("Unable to set video mode: %s\n", SDL_GetError());
 		exit(1);
 	}
+	inputInit(threaded);
 
-	gfxInit(44100, 1024);
+	gfxInit(FREQ, buffer);
 	setScale(0, 1000, 0, 1000, 100);
 
 	srand(time(NULL));
@@ -88,55 +86,26 @@ double randReal(double low, double high) {
 	return low + rand()/(((double)RAND_MAX + 1) / (high-low));
 }
 
-//takes bytes instead of point count for easy use with sizeof
-void drawObj(const double *obj, double angle, double radius, double offX, double offY, double bright, int bytes) {
-	double r, theta, x, y;
-	int i;
-	int nPts = bytes/(2*sizeof(obj[0]));
-
-	if(nPts < 2) return;	//need at least 2 points
-
-	//move to first point
-	r = obj[0];
-	theta = obj[1];
-	x = radius * r * cos(angle + theta) + offX;
-	y = radius * r * sin(angle + theta) + offY;
-	moveTo(x, y);
-	lineTo(x, y, bright/2);
-
-	//line to remaining points
-	for(i=1; i<nPts; i++) {
-		r = obj[2*i+0];
-		theta = obj[2*i+1];
-		x = radius * r * cos(angle + theta) + offX;
-		y = radius * r * sin(angle + theta) + offY;
-		lineTo(x, y, bright);
-	}
+//a new object id, never the ship's
+int newId(void) {
+	static int id = SHIP_ID;
+
+	return ++id;
 }
 
-//draw a box around the screen, starting at a random location
-//helps stabilize the picture on an analog oscilloscope
-void recenter(void) {
-#ifndef NOBOX
-	int i, offs = rand()%4, j;
-	static const double box[] = {
-		0, 0,
-		1000, 0,
-		1000, 1000,
-		0, 1000,
-	};
-
-	moveTo(box[offs*2], box[offs*2+1]);
-	for(i=1; i<5; i++) {
-		j = 2*((i+offs)%4);
-		lineTo(box[j], box[j+1], 0.3);
-	}
-#endif
+//print the command line options and quit
+void usage(const char *prog) {
+	printf("Usage: %s [-backend name] [-record file.vrec] [-models file.vmod] [-heatmap file.pgm] [-buffer N|auto] [-queue N latest|fifo|oldest] [-anglesteps N] [-lod Hz] [-midswitch] [-simplify] [-stabilize N] [-interpolate]\nBackends:\n", prog);
+	gfxListBackends(stdout);
+	exit(1);
 }
 
 int main(int argc, char **argv) {
 	char title[512];
-	SDL_Event ev;
+	char hud[TEXT_MAX_LEN+1];
+	struct inputEvent in;
+	Uint64 now, last, tickStart;
+	double thrustTime, spinTime, tickTime;
 	int running=1;
 	int mode = 0;
 	int titlescr = 1;
@@ -152,16 +121,102 @@ int main(int argc, char **argv) {
 	char fragmentValid[MAX_FRAGMENTS];
 
 	double posX=500, posY=500;
-	int shoot=0, spin=0, thrust=0;
+	int shoot=0, spin=0, thrust=0, tapped=0;
 	double spdX=0, spdY=0, angle=-PI/2;
 	double r, theta, dx, dy, x, y;
 	int flame = 0;
 	int dead = 0;
 	int kills = 0, last_kills = 0;
 
+	struct modelSet models;
+	const char *modelFile = NULL;
+	const char *recordFile = NULL;
+	const char *heatMap = NULL;
+	struct beamStats beam;
+	long beamTotal;
+	int ticks = 0;
+
+	struct vlod roidLod, logoLod;
+	int v, lodHz = LOD_HZ;
+	double lodError;
+
+	struct vcache roidCache;
+	int roidSteps = ROID_ANGLE_STEPS;
+	int buffer = 1024;
+	int queueDepth = 1, queuePolicy = QUEUE_LATEST, midSwitch = 0, simplify = 0, interpolate = 0;
+	int stabilize = STABILIZE_SAMPLES;
+	const float *pts;
+
 	int i, j, k;
 
-	sys_initialize();
+	//command line options, before sys_initialize starts the graphics
+	for(i=1; i<argc; i++) {
+		if(!strcmp(argv[i], "-backend") && i+1 < argc) {
+			//where to draw: scope, window, shm, file or null
+			gfxSelectBackend(argv[++i]);
+		} else if(!strcmp(argv[i], "-record") && i+1 < argc) {
+			//save all drawing for the replay program
+			recordFile = argv[++i];
+		} else if(!strcmp(argv[i], "-models") && i+1 < argc) {
+			//shapes from a model file instead of the ones compiled in, reloaded when it changes
+			modelFile = argv[++i];
+		} else if(!strcmp(argv[i], "-heatmap") && i+1 < argc) {
+			//write where the beam spent its time to a PGM image at the end
+			heatMap = argv[++i];
+		} else if(!strcmp(argv[i], "-buffer") && i+1 < argc) {
+			//sound card buffer in samples, or auto to find the smallest that works here
+			i++;
+			buffer = strcmp(argv[i], "auto") ? atoi(argv[i]) : GFX_BUFFER_AUTO;
+		} else if(!strcmp(argv[i], "-queue") && i+2 < argc) {
+			//frames that can wait to be drawn, and what to do when they can't
+			queueDepth = atoi(argv[++i]);
+			i++;
+			if(!strcmp(argv[i], "fifo")) queuePolicy = QUEUE_FIFO;
+			else if(!strcmp(argv[i], "oldest")) queuePolicy = QUEUE_DROP_OLDEST;
+			else if(!strcmp(argv[i], "latest")) queuePolicy = QUEUE_LATEST;
+			else {
+				printf("Unknown queue policy %s\n", argv[i]);
+				usage(argv[0]);
+			}
+		} else if(!strcmp(argv[i], "-midswitch")) {
+			//start drawing new frames at the next stroke instead of the next pass
+			midSwitch = 1;
+		} else if(!strcmp(argv[i], "-simplify")) {
+			//merge redundant points before rendering each frame
+			simplify = 1;
+		} else if(!strcmp(argv[i], "-interpolate")) {
+			//move things smoothly between game ticks each time the scope redraws
+			interpolate = 1;
+		} else if(!strcmp(argv[i], "-stabilize") && i+1 < argc) {
+			//samples of drawing between borders that steady the picture, 0 for none
+			stabilize = atoi(argv[++i]);
+		} else if(!strcmp(argv[i], "-lod") && i+1 < argc) {
+			//refresh rate to keep busy screens at by simplifying shapes, 0 for full detail always
+			lodHz = atoi(argv[++i]);
+		} else if(!strcmp(argv[i], "-anglesteps") && i+1 < argc) {
+			//asteroid rotation steps to cache, 0 to rotate every point every frame
+			roidSteps = atoi(argv[++i]);
+		} else {
+			printf("Unknown option %s\n", argv[i]);
+			usage(argv[0]);
+		}
+	}
+
+	sys_initialize(buffer);
+	//after SDL_Init, since it times the flips with SDL_GetTicks
+	if(recordFile != NULL) gfxRecord(recordFile);
+	setFrameQueue(queueDepth, queuePolicy);
+	setMidFrameSwitch(midSwitch);
+	setSimplify(simplify);
+	setStabilize(stabilize);
+	setInterpolate(interpolate);
+	if(heatMap != NULL) setHeatMap(heatMap);
+
+	vmodelBuiltin(&models);
+	if(modelFile != NULL && !vmodelLoad(&models, modelFile)) exit(1);
+	vlodInit(&roidLod, models.roids, models.nroids);
+	vlodInit(&logoLod, models.logo, models.nletters);
+	vcacheInit(&roidCache, roidLod.models, models.nroids*LOD_LEVELS, roid_radius, roid_nsplit, roidSteps);
 
 	printf("\n--------------------------------------------------------------------------------\n");
 	printf("--------------------------------------------------------------------------------\n");
@@ -180,7 +235,8 @@ int main(int argc, char **argv) {
 
 	//make some sample asteroids
 	for(i=0; i<7; i++) {
-		roids[i].model = rand()%nroid_models;
+		roids[i].id = newId();
+		roids[i].model = rand()%models.nroids;
 		roids[i].split = rand()%roid_nsplit;
 		roids[i].angle = randReal(-PI, PI);
 		roids[i].spin = randReal(-PI/64, PI/64);
@@ -191,13 +247,45 @@ int main(int argc, char **argv) {
 		roidValid[i] = 1;
 	}
 
+	PROF_THREAD("game loop");
+	tickStart = profNow();
+
 	while(running) {
-		//handle input
-		while(SDL_PollEvent(&ev)) {
-			switch(ev.type) {
+		PROF_BEGIN(tFrame);
+		PROF_BEGIN(tPhase);
+
+		//pick up new shapes if the model file has been replaced; the cache and
+		//the asteroids refer to the old ones
+		if(modelFile != NULL && ++ticks % MODEL_CHECK_TICKS == 0 && vmodelReload(&models, modelFile)) {
+			vcacheFree(&roidCache);
+			vlodFree(&roidLod);
+			vlodFree(&logoLod);
+			vlodInit(&roidLod, models.roids, models.nroids);
+			vlodInit(&logoLod, models.logo, models.nletters);
+			vcacheInit(&roidCache, roidLod.models, models.nroids*LOD_LEVELS, roid_radius, roid_nsplit, roidSteps);
+			for(i=0; i<MAX_ROIDS; i++) if(roidValid[i]) roids[i].model %= models.nroids;
+			printf("Reloaded models from %s\n", modelFile);
+		}
+
+		//how much detail can be spared this tick, going by how busy the last few frames were
+		getBeamStats(&beam);
+		lodError = vlodAllowed(beam.recent[BEAM_LINE] + beam.recent[BEAM_DWELL] + beam.recent[BEAM_JUMP] + beam.recent[BEAM_BORDER], FREQ, lodHz);
+
+		//handle input since the last tick, in the order it happened, timing how
+		//long thrust and spin were on in between
+		now = profNow();
+		last = tickStart;
+		thrustTime = spinTime = 0;
+		while(inputPoll(&in, now)) {
+			if(in.time > last) {
+				thrustTime += thrust * (double)(in.time - last);
+				spinTime += spin * (double)(in.time - last);
+				last = in.time;
+			}
+			switch(in.type) {
 				case SDL_KEYDOWN:
 					//process pressed keys
-					switch(ev.key.keysym.sym) {
+					switch(in.key) {
 						case SDLK_r:
 							if(dead) {
 								dead=0;
@@ -207,12 +295,16 @@ int main(int argc, char **argv) {
 						case SDLK_SPACE:
 							if(titlescr) {
 								titlescr=0;
+								//shapes going off one edge come back at the other
+								//(not on the title screen, where asteroids bounce off the title)
+								setWrap(1);
 								//reset asteroids
 								memset(roidValid, 0, MAX_ROIDS);
 
 								//make some asteroids
 								for(i=0; i<INIT_ROIDS; i++) {
-									roids[i].model = rand()%nroid_models;
+									roids[i].id = newId();
+									roids[i].model = rand()%models.nroids;
 									roids[i].split = 0;
 									roids[i].angle = randReal(-PI, PI);
 									roids[i].spin = randReal(-PI/64, PI/64);
@@ -227,7 +319,10 @@ int main(int argc, char **argv) {
 									roids[i].posY = y;
 									roidValid[i] = 1;
 								}
-							} else if(!dead) shoot=RAPIDFIRE_DELAY;
+							} else if(!dead) {
+								shoot=RAPIDFIRE_DELAY;
+								tapped=1;	//fire even if it's let go before the next tick
+							}
 							break;
 						case SDLK_UP:
 							if(!dead && !titlescr) {
@@ -267,7 +362,7 @@ int main(int argc, char **argv) {
 					break;
 				case SDL_KEYUP:
 					//process released keys
-					switch(ev.key.keysym.sym) {
+					switch(in.key) {
 						case SDLK_SPACE:
 							shoot=0;
 							break;
@@ -303,14 +398,23 @@ int main(int argc, char **argv) {
 			}
 		}
 
+		//what's left of the tick since the last event
+		thrustTime += thrust * (double)(now - last);
+		spinTime += spin * (double)(now - last);
+		tickTime = now - tickStart;
+		if(tickTime <= 0) tickTime = 1;	//the very first tick can start in the same microsecond
+		tickStart = now;
+
+		PROF_NEXT(tPhase, "input");
+
 		//update state
-		//thrusters
-		if(thrust) {
-			spdX += thrust * THRUST * cos(angle);
-			spdY += thrust * THRUST * sin(angle);
+		//thrusters, for the part of the tick they were on
+		if(thrustTime != 0) {
+			spdX += thrustTime/tickTime * THRUST * cos(angle);
+			spdY += thrustTime/tickTime * THRUST * sin(angle);
 		}
-		//spin
-		angle += spin * SPIN;
+		//spin, likewise
+		angle += spinTime/tickTime * SPIN;
 		if(angle > PI) angle -= 2*PI;
 		else if(angle < -PI) angle += 2*PI;
 		//movement
@@ -331,16 +435,19 @@ int main(int argc, char **argv) {
 		else if(posY < 0) posY += 1000;
 
 		//shooting
-		if(shoot) {
-			if(shoot++ >= RAPIDFIRE_DELAY) {
+		if(shoot || tapped) {
+			if(tapped || shoot++ >= RAPIDFIRE_DELAY) {
 				//if this starts at 0, you have to push space again to shoot again
 				//if it's 1, it starts counting up again till the next shot
-				shoot = RAPIDFIRE_ENABLE;
+				//(and if space is already up again, it stays 0)
+				if(shoot) shoot = RAPIDFIRE_ENABLE;
+				tapped = 0;
 
 				//find an unused bullet
 				for(i=0; i<MAX_BULLETS && bulletValid[i]; i++);
 				if(i < MAX_BULLETS) {
 					//found an unused bullet slot, we can shoot
+					bullets[i].id = newId();
 					bullets[i].posX = posX;
 					bullets[i].posY = posY;
 					bullets[i].angle = angle;
@@ -352,25 +459,30 @@ int main(int argc, char **argv) {
 			}
 		}
 
+		PROF_NEXT(tPhase, "ship physics");
+
 		//draw screen
 		//logo
 		if(titlescr) {
-			for(i=0; i<logo_letters; i++) {
-				drawObj(logo_p[i], 0, logo_radius, 500, 150, 1.0, logo_len[i]*2*sizeof(logo_p[0][0]));
-				recenter();
+			for(i=0; i<models.nletters; i++) {
+				drawObj(&logoLod.models[vlodPick(&logoLod, i, logo_radius, lodError)], 0, logo_radius, 500, 150, 1.0);
 			}
 		}
 
 		//ship
 		if(!dead && !titlescr) {
-			drawObj(ship_p, angle, ship_radius, posX, posY, 1.0, sizeof(ship_p));
-			if(thrust>0) flame = !flame; else flame=0;
+			beginObject(SHIP_ID, posX, posY, angle);
+			drawObj(models.ship, angle, ship_radius, posX, posY, 1.0);
+			if(thrustTime>0) flame = !flame; else flame=0;
 			if(flame) {
-				drawObj(flame_p, angle, ship_radius, posX, posY, 1.0, sizeof(flame_p));
-				drawObj(flame_p, angle, ship_radius, posX, posY, 1.0, sizeof(flame_p));
+				drawObj(models.flame, angle, ship_radius, posX, posY, 1.0);
+				drawObj(models.flame, angle, ship_radius, posX, posY, 1.0);
 			}
+			endObject();
 		}
 
+		PROF_NEXT(tPhase, "draw ship");
+
 		//update and draw bullets
 		for(i=0; i<MAX_BULLETS; i++) {
 			if(!bulletValid[i]) continue;
@@ -411,7 +523,8 @@ int main(int argc, char **argv) {
 							for(k=0; k<MAX_ROIDS && roidValid[k]; k++);
 							if(k<MAX_ROIDS) {
 								//new asteroid goes in position k
-								roids[k].model = rand()%nroid_models;
+								roids[k].id = newId();
+								roids[k].model = rand()%models.nroids;
 								roids[k].split = a->split;
 								roids[k].angle = randReal(-PI, PI);
 								roids[k].spin = randReal(-PI/64, PI/64);
@@ -424,8 +537,9 @@ int main(int argc, char **argv) {
 								roids[k].posY = a->posY + 6*roids[k].spdY;
 								roidValid[k] = 1;
 
-								//fix up the old one too
-								a->model = rand()%nroid_models;
+								//fix up the old one too, which is a different shape now
+								a->id = newId();
+								a->model = rand()%models.nroids;
 								a->angle = randReal(-PI, PI);
 								a->spin = randReal(-PI/64, PI/64);
 								a->spdX += randReal(-ROID_SPEED, ROID_SPEED);
@@ -440,12 +554,15 @@ int main(int argc, char **argv) {
 				}
 
 				//draw it
-				if(!titlescr)
-					drawObj(bullet_p, b->angle, 1.0, b->posX, b->posY, 1.0, sizeof(bullet_p));
+				if(!titlescr) {
+					beginObject(b->id, b->posX, b->posY, b->angle);
+					drawObj(models.bullet, b->angle, 1.0, b->posX, b->posY, 1.0);
+					endObject();
+				}
 			}
 		}
 
-		recenter();
+		PROF_NEXT(tPhase, "bullets");
 
 		//update and draw fragments
 		for(i=0; i<MAX_FRAGMENTS; i++) {
@@ -463,10 +580,14 @@ int main(int argc, char **argv) {
 				f->angle += f->spin;
 
 				//draw it
-				drawObj(bullet_p, f->angle, 2.0, f->posX, f->posY, 1.0, sizeof(bullet_p));
+				beginObject(f->id, f->posX, f->posY, f->angle);
+				drawObj(models.bullet, f->angle, 2.0, f->posX, f->posY, 1.0);
+				endObject();
 			}
 		}
 
+		PROF_NEXT(tPhase, "fragments");
+
 		//process and draw asteroids
 		j=0;
 		for(i=0; i<MAX_ROIDS; i++) {
@@ -499,6 +620,7 @@ int main(int argc, char **argv) {
 				int this_kills;
 				//generate debris
 				for(k=0; k<MAX_FRAGMENTS; k++) {
+					fragments[k].id = newId();
 					fragments[k].posX = posX + randReal(-ship_radius, ship_radius);
 					fragments[k].posY = posY + randReal(-ship_radius, ship_radius);
 					fragments[k].spdX = randReal(-4, 4);
@@ -513,7 +635,7 @@ int main(int argc, char **argv) {
 				posX = posY = 500;
 				spdX = spdY = 0;
 				angle = -PI/2;
-				shoot = spin = thrust = 0;
+				shoot = spin = thrust = tapped = 0;
 				flame = 0;
 				this_kills = kills - last_kills;
 				last_kills = kills;
@@ -529,10 +651,18 @@ int main(int argc, char **argv) {
 			}
 
 			//draw it
-			drawObj(roids_p[a->model], a->angle, roid_radius[a->split], a->posX, a->posY, 0.8-0.1*a->split, sizeof(roids_p[0]));
-			recenter();
+			beginObject(a->id, a->posX, a->posY, a->angle);
+			v = vlodPick(&roidLod, a->model, roid_radius[a->split], lodError);
+			pts = vcacheGet(&roidCache, v, a->split, a->angle);
+			if(pts != NULL)
+				drawPts(pts, roidLod.models[v].n, a->posX, a->posY, 0.8-0.1*a->split);
+			else
+				drawObj(&roidLod.models[v], a->angle, roid_radius[a->split], a->posX, a->posY, 0.8-0.1*a->split);
+			endObject();
 		}
 
+		PROF_NEXT(tPhase, "asteroids");
+
 		//asteroid respawn
 		if(j < ROID_RESPAWN_THRESHOLD && kills>0 && ++roidRespawn > ROID_RESPAWN_DELAY) {
 			if(randReal(0.0, 1.0) < ROID_RESPAWN_RATE) {
@@ -542,7 +672,8 @@ int main(int argc, char **argv) {
 					printf("WARNING: Can't respawn asteroid because the array is full!\n");
 				} else {
 					//make new asteroid
-					roids[i].model = rand()%nroid_models;
+					roids[i].id = newId();
+					roids[i].model = rand()%models.nroids;
 					roids[i].split = 0;
 					roids[i].angle = randReal(-PI, PI);
 					roids[i].spin = randReal(-PI/64, PI/64);
@@ -561,14 +692,51 @@ int main(int argc, char **argv) {
 			roidRespawn = 0;
 		}
 
-		recenter();
+		PROF_NEXT(tPhase, "respawn");
+
+#ifndef NOHUD
+		//score, and how to get back in when dead
+		if(!titlescr) {
+			snprintf(hud, sizeof(hud), "%d", kills);
+			drawText(hud, HUD_SIZE, HUD_SIZE, HUD_SIZE, HUD_BRIGHT);
+			if(dead) drawText("PRESS R", 500 - textWidth("PRESS R", HUD_SIZE)/2, 500 - HUD_SIZE/2, HUD_SIZE, HUD_BRIGHT);
+		}
+#endif
+
+		PROF_NEXT(tPhase, "hud");
 
 		flip(1);
-		snprintf(title, sizeof(title), "Asteroids [%d Hz]", (int)(getRefreshRate()+0.5));
+
+		PROF_NEXT(tPhase, "flip");
+
+		snprintf(title, sizeof(title), "Asteroids [%d Hz, %d queued, %ld dropped]", (int)(getRefreshRate()+0.5), getQueuedFrames(), getDroppedFrames());
 		SDL_WM_SetCaption(title, title);
-		SDL_Delay(50);
+
+		PROF_NEXT(tPhase, "title bar");
+
+		inputWait(50);
+
+		PROF_END(tPhase, "sleep");
+		PROF_END(tFrame, "frame");
 	}
 
+	PROF_DUMP(PROF_FILE);
+
+	vcacheReport(&roidCache, "Asteroid rotation", stdout);
+	vlodReport(&roidLod, "Asteroid", stdout);
+
+	//how much of the beam's time went on drawing things, and how much getting between them
+	getBeamStats(&beam);
+	beamTotal = beam.total[BEAM_LINE] + beam.total[BEAM_DWELL] + beam.total[BEAM_JUMP] + beam.total[BEAM_BORDER];
+	if(beamTotal > 0)
+		printf("Beam time: %.1f%% lines, %.1f%% dots, %.1f%% jumps, %.1f%% borders, %ld samples a frame\n",
+			100.0*beam.total[BEAM_LINE]/beamTotal, 100.0*beam.total[BEAM_DWELL]/beamTotal,
+			100.0*beam.total[BEAM_JUMP]/beamTotal, 100.0*beam.total[BEAM_BORDER]/beamTotal, beamTotal/beam.frames);
+	vcacheFree(&roidCache);
+	vlodFree(&roidLod);
+	vlodFree(&logoLod);
+	vmodelFree(&models);
+
 	printf("\nProgram terminating. Showing great courage, you have destroyed %d asteroid(s),\nbut %d more remain.\n\n", kills, rand()+9001);
 
 	return 0;
@@ -0,0 +1,208 @@
+/* Generates asteroids_models.h from the shapes in asteroids_objects.h
+ *
+ * The shapes were modeled in polar coordinates, which is handy for editing
+ * but means drawing them takes a sin and cos for every point. This runs at
+ * build time and writes them out as Cartesian x,y tables that only need
+ * rotating and scaling, along with each model's point count, line count and
+ * bounding radius. Everything it writes is static const, so the header can be
+ * included from as many .c files as you like.
+ *
+ * Usage: mkmodels > asteroids_models.h    (the makefile does this for you)
+ *        mkmodels -vmod file.vmod         (the same shapes as a model file,
+ *                                          see vmodel.h)
+ *
+ * I'm releasing this code under the WTFPL. You can do whatever you like with
+ * it, though I'd appreciate credit and thanks if you find it useful or fun.
+ * See LICENSE.txt for details.
+ *            -Joe McKenzie / Chupi
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "asteroids_objects.h"
+#include "vmodel.h"
+
+//write n polar points as x,y pairs; returns the bounding radius
+static double writePoints(const double *p, int n) {
+	double radius = 0;
+	int i;
+
+	for(i=0; i<n; i++) {
+		printf("\t%10.6ff, %10.6ff,\n", p[2*i] * cos(p[2*i+1]), p[2*i] * sin(p[2*i+1]));
+		if(p[2*i] > radius) radius = p[2*i];
+	}
+	return radius;
+}
+
+//a table and model for a single shape
+static void writeModel(const char *name, const double *p, int bytes) {
+	int n = bytes / (2*sizeof(p[0]));
+	double radius;
+
+	printf("static const float %s_xy[] = {\n", name);
+	radius = writePoints(p, n);
+	printf("};\n");
+	printf("static const struct model %s_model = {%s_xy, %d, %d, %.6ff};\n\n", name, name, n, n-1, radius);
+}
+
+//the float the compiler makes of what's printed in the header, so a model
+//file holds exactly the same shapes
+static float asFloat(double x) {
+	char s[32];
+
+	snprintf(s, sizeof(s), "%.6f", x);
+	return (float)atof(s);
+}
+
+//a model file's entries and points, added to as it's built: room for every
+//shape in asteroids_objects.h (the logo's table is padded, so it's plenty)
+#define VMOD_MODELS (3 + sizeof(roids_p)/sizeof(roids_p[0]) + sizeof(logo_p)/sizeof(logo_p[0]))
+#define VMOD_POINTS ((sizeof(ship_p) + sizeof(flame_p) + sizeof(bullet_p) + sizeof(roids_p) + sizeof(logo_p)) / (2*sizeof(double)))
+static struct vmodEntry vmodEntries[VMOD_MODELS];
+static float vmodPoints[2*VMOD_POINTS];
+static int vmodModels, vmodPointCount;
+
+static void addModel(const char *name, const double *p, int n) {
+	struct vmodEntry *e = &vmodEntries[vmodModels++];
+	double radius = 0;
+	int i;
+
+	memset(e, 0, sizeof(struct vmodEntry));
+	strncpy(e->name, name, VMOD_NAME_LEN-1);
+	e->first = vmodPointCount;
+	e->n = n;
+	e->strokes = n-1;
+	for(i=0; i<n; i++) {
+		vmodPoints[2*vmodPointCount] = asFloat(p[2*i] * cos(p[2*i+1]));
+		vmodPoints[2*vmodPointCount+1] = asFloat(p[2*i] * sin(p[2*i+1]));
+		vmodPointCount++;
+		if(p[2*i] > radius) radius = p[2*i];
+	}
+	e->radius = asFloat(radius);
+}
+
+//write everything as a model file; written beside it and renamed into place,
+//so a running game never sees half of one
+static int writeVmod(const char *filename) {
+	struct vmodHeader h;
+	char tmp[1024];
+	FILE *f;
+	int i;
+
+	addModel("ship", ship_p, sizeof(ship_p) / (2*sizeof(ship_p[0])));
+	addModel("flame", flame_p, sizeof(flame_p) / (2*sizeof(flame_p[0])));
+	addModel("bullet", bullet_p, sizeof(bullet_p) / (2*sizeof(bullet_p[0])));
+	for(i=0; i<nroid_models; i++)
+		addModel("roid", roids_p[i], sizeof(roids_p[0]) / (2*sizeof(roids_p[0][0])));
+	for(i=0; i<logo_letters; i++)
+		addModel("logo", logo_p[i], logo_len[i]);
+
+	memcpy(h.magic, VMOD_MAGIC, 4);
+	h.version = VMOD_VERSION;
+	h.nmodels = vmodModels;
+	h.npoints = vmodPointCount;
+
+	snprintf(tmp, sizeof(tmp), "%s.tmp", filename);
+	f = fopen(tmp, "wb");
+	if(f == NULL) {
+		perror(tmp);
+		return 1;
+	}
+	fwrite(&h, sizeof(h), 1, f);
+	fwrite(vmodEntries, sizeof(struct vmodEntry), vmodModels, f);
+	fwrite(vmodPoints, 2*sizeof(float), vmodPointCount, f);
+	if(ferror(f) | fclose(f)) {
+		perror(tmp);
+		remove(tmp);
+		return 1;
+	}
+#ifdef _WIN32
+	//rename won't replace a file here, so there's a moment with no file at all,
+	//which the game just waits out (see vmodelReload)
+	remove(filename);
+#endif
+	if(rename(tmp, filename)) {
+		perror(filename);
+		remove(tmp);
+		return 1;
+	}
+	return 0;
+}
+
+int main(int argc, char **argv) {
+	//sized from the tables, so adding shapes never needs this changed
+	double roidRadius[sizeof(roids_p) / sizeof(roids_p[0])];
+	double logoRadius[sizeof(logo_p) / sizeof(logo_p[0])];
+	int offset[sizeof(logo_p) / sizeof(logo_p[0])];
+	int i, n;
+
+	if(argc == 3 && !strcmp(argv[1], "-vmod")) return writeVmod(argv[2]);
+	if(argc != 1) {
+		fprintf(stderr, "Usage: %s [-vmod file.vmod]\n", argv[0]);
+		return 1;
+	}
+
+	printf("/* Vector objects for Asteroids, in Cartesian coordinates\n");
+	printf(" *\n");
+	printf(" * GENERATED by mkmodels from asteroids_objects.h. Don't edit this, edit that.\n");
+	printf(" */\n\n");
+	printf("#ifndef __ASTEROIDS_MODELS_H__\n");
+	printf("#define __ASTEROIDS_MODELS_H__\n\n");
+
+	printf("//a shape, drawn as one connected line through all its points\n");
+	printf("struct model {\n");
+	printf("\tconst float *xy;	//x,y pairs, relative to the center, scaled so nominal radius is 1\n");
+	printf("\tint n;	//number of points\n");
+	printf("\tint strokes;	//number of lines drawn between them\n");
+	printf("\tfloat radius;	//distance of the farthest point from the center\n");
+	printf("};\n\n");
+
+	printf("//player ship and the flame added when the thruster is on\n");
+	printf("static const double ship_radius = %.6f;\n", ship_radius);
+	writeModel("ship", ship_p, sizeof(ship_p));
+	writeModel("flame", flame_p, sizeof(flame_p));
+
+	printf("//bullet (and debris when you die)\n");
+	writeModel("bullet", bullet_p, sizeof(bullet_p));
+
+	printf("//asteroids\n");
+	printf("static const double roid_radius[] = {");
+	for(i=0; i<roid_nsplit; i++) printf("%s%.6f", i ? ", " : "", roid_radius[i]);
+	printf("};\n");
+	printf("static const int roid_nsplit = %d;\n", roid_nsplit);
+	printf("static const int nroid_models = %d;\n", nroid_models);
+	n = sizeof(roids_p[0]) / (2*sizeof(roids_p[0][0]));
+	printf("static const float roid_xy[][%d] = {\n", 2*n);
+	for(i=0; i<nroid_models; i++) {
+		printf("{\n");
+		roidRadius[i] = writePoints(roids_p[i], n);
+		printf("},\n");
+	}
+	printf("};\n");
+	printf("static const struct model roid_models[] = {\n");
+	for(i=0; i<nroid_models; i++)
+		printf("\t{roid_xy[%d], %d, %d, %.6ff},\n", i, n, n-1, roidRadius[i]);
+	printf("};\n\n");
+
+	//letters are different lengths, so pack them into one table without padding
+	printf("//title logo, one model per letter\n");
+	printf("static const double logo_radius = %.6f;\n", logo_radius);
+	printf("static const int logo_letters = %d;\n", logo_letters);
+	printf("static const float logo_xy[] = {\n");
+	for(i=0, n=0; i<logo_letters; i++) {
+		offset[i] = n;
+		printf("\t//letter %d\n", i);
+		logoRadius[i] = writePoints(logo_p[i], logo_len[i]);
+		n += 2*logo_len[i];
+	}
+	printf("};\n");
+	printf("static const struct model logo_models[] = {\n");
+	for(i=0; i<logo_letters; i++)
+		printf("\t{logo_xy+%d, %d, %d, %.6ff},\n", offset[i], logo_len[i], logo_len[i]-1, logoRadius[i]);
+	printf("};\n\n");
+
+	printf("#endif\n");
+	return 0;
+}
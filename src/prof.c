@@ -0,0 +1,99 @@
+/* Lightweight frame profiler with Chrome trace output (see prof.h)
+ *
+ * I'm releasing this code under the WTFPL. You can do whatever you like with
+ * it, though I'd appreciate credit and thanks if you find it useful or fun.
+ * See LICENSE.txt for details.
+ *            -Joe McKenzie / Chupi
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+#include "prof.h"
+
+struct profEvent {
+	const char *name;
+	Uint32 tid;
+	Uint64 start, dur;
+};
+
+static struct profEvent events[PROF_EVENTS];
+static volatile Uint32 nextEvent = 0;	//total ever recorded; wraps around the ring
+
+//names given to threads with profThreadName
+#define PROF_THREADS 16
+static struct {
+	Uint32 tid;
+	const char *name;
+} threads[PROF_THREADS];
+static volatile Uint32 nthreads = 0;
+
+Uint64 profNow(void) {
+#ifdef _WIN32
+	static LARGE_INTEGER freq;
+	LARGE_INTEGER now;
+
+	if(freq.QuadPart == 0) QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&now);
+	return (Uint64)(now.QuadPart / freq.QuadPart) * 1000000 + (Uint64)(now.QuadPart % freq.QuadPart) * 1000000 / freq.QuadPart;
+#else
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (Uint64)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#endif
+}
+
+void profRecord(const char *name, Uint64 start, Uint64 end) {
+	//claim a slot without locking, so the audio callback never waits on us
+	Uint32 i = __sync_fetch_and_add(&nextEvent, 1) % PROF_EVENTS;
+
+	events[i].name = name;
+	events[i].tid = SDL_ThreadID();
+	events[i].start = start;
+	events[i].dur = end - start;
+}
+
+void profThreadName(const char *name) {
+	Uint32 i = __sync_fetch_and_add(&nthreads, 1);
+
+	if(i >= PROF_THREADS) return;
+	threads[i].tid = SDL_ThreadID();
+	threads[i].name = name;
+}
+
+void profDump(const char *filename) {
+	Uint32 n = nextEvent, first, i;
+	Uint64 t0;
+	FILE *f;
+
+	f = fopen(filename, "w");
+	if(f == NULL) {
+		perror(filename);
+		return;
+	}
+
+	//oldest event still in the ring
+	first = n > PROF_EVENTS ? n - PROF_EVENTS : 0;
+	t0 = n > first ? events[first % PROF_EVENTS].start : 0;
+
+	fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	fprintf(f, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"asteroids\"}}");
+	for(i=0; i<nthreads && i<PROF_THREADS; i++)
+		fprintf(f, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}", threads[i].tid, threads[i].name);
+	for(i=first; i<n; i++) {
+		struct profEvent *e = &events[i % PROF_EVENTS];
+		//timestamps relative to the first event, so they're small and readable
+		fprintf(f, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+			e->name, e->tid, e->start >= t0 ? (double)(e->start - t0) : 0.0, (double)e->dur);
+	}
+	fprintf(f, "\n]}\n");
+	fclose(f);
+
+	fprintf(stderr, "Wrote %u profiler events to %s\n", n - first, filename);
+}
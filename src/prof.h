@@ -0,0 +1,67 @@
+/* Lightweight frame profiler with Chrome trace output
+ *
+ * Wrap a piece of code in PROF_BEGIN/PROF_END to time it:
+ *
+ *    PROF_BEGIN(t);
+ *    ...stuff...
+ *    PROF_END(t, "stuff");
+ *
+ * PROF_NEXT(t, "stuff") ends one timing and starts the next with the same
+ * variable, for timing a sequence of phases back to back.
+ *
+ * Each timing goes into a fixed-size ring buffer; once it's full, the oldest
+ * ones are overwritten. PROF_DUMP writes what's there as Chrome trace event
+ * JSON, which you can load into Perfetto (ui.perfetto.dev) or chrome://tracing
+ * to see where each frame's time went, per thread.
+ *
+ * All of this only exists when built with -DPROFILE. Otherwise the macros
+ * expand to nothing, so they cost nothing in normal builds.
+ *
+ * It's safe to record from several threads at once (the game loop and the
+ * sound card callback, for example). Dumping while other threads are still
+ * recording may catch an event half-written, which just shows up oddly in the
+ * trace.
+ *
+ * I'm releasing this code under the WTFPL. You can do whatever you like with
+ * it, though I'd appreciate credit and thanks if you find it useful or fun.
+ * See LICENSE.txt for details.
+ *            -Joe McKenzie / Chupi
+ */
+
+#ifndef __PROF_H__
+#define __PROF_H__
+
+#include "SDL/SDL.h"
+
+#define PROF_EVENTS 65536	//size of the ring buffer
+#define PROF_FILE "asteroids-trace.json"	//default dump file
+
+/* profNow: microseconds since some arbitrary point, from the best clock the
+ *   platform has. Always available, even without -DPROFILE.                 */
+extern Uint64 profNow(void);
+
+/* profRecord: save one timed event. name must be a string that won't go away
+ *   (a literal). Use the macros instead of calling this directly.           */
+extern void profRecord(const char *name, Uint64 start, Uint64 end);
+
+/* profThreadName: label the calling thread in the trace                     */
+extern void profThreadName(const char *name);
+
+/* profDump: write everything in the ring buffer to filename as JSON         */
+extern void profDump(const char *filename);
+
+#ifdef PROFILE
+#define PROF_BEGIN(var) Uint64 var = profNow()
+#define PROF_END(var, name) profRecord(name, var, profNow())
+#define PROF_NEXT(var, name) do { Uint64 now_ = profNow(); profRecord(name, var, now_); var = now_; } while(0)
+#define PROF_THREAD(name) profThreadName(name)
+#define PROF_DUMP(filename) profDump(filename)
+#else
+#define PROF_BEGIN(var)
+#define PROF_END(var, name)
+#define PROF_NEXT(var, name)
+#define PROF_THREAD(name)
+#define PROF_DUMP(filename)
+#endif
+
+#endif
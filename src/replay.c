@@ -0,0 +1,254 @@
+/* Replays a draw call recording made with gfxRecord (see gfx_record.h)
+ *
+ * Can play through any graphics backend, just like the game, so the same
+ * recording can drive the scope, the window or anything else. By default it
+ * goes as fast as it can and reports how long the drawing took, which makes it
+ * a repeatable benchmark for changes to the backends using real gameplay. The
+ * null backend times the renderer alone, without the sound card.
+ *
+ * Usage: replay-scope [-backend name] [-realtime] [-simplify] [-stabilize N] [-interpolate] [-loop N] recording.vrec
+ *   -backend name: where to draw (see gfxSelectBackend in gfx.h)
+ *   -realtime: wait between frames as long as the game did when it was recorded
+ *   -simplify: merge redundant points before rendering (see setSimplify in gfx.h)
+ *   -stabilize N: steadying borders every N samples, as the game draws them
+ *     by default (see setStabilize in gfx.h); recordings don't include them
+ *   -interpolate: move objects smoothly between frames (see setInterpolate in
+ *     gfx.h); best with -realtime, so the frames take as long as they did
+ *   -loop N: play the recording N times (default 1)
+ *
+ * To make a recording, run the game with -record recording.vrec
+ *
+ * I'm releasing this code under the WTFPL. You can do whatever you like with
+ * it, though I'd appreciate credit and thanks if you find it useful or fun.
+ * See LICENSE.txt for details.
+ *            -Joe McKenzie / Chupi
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+#include "gfx.h"
+#include "gfx_record.h"
+
+//Windows opens files as text unless told not to
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+//recording being decoded
+static const Uint8 *data, *pos, *end;
+
+//decoder state, mirrors the recorder
+static double xmin, xmax, ymin, ymax;
+static long qx, qy;
+static double weight;
+
+static void corrupt(void) {
+	fprintf(stderr, "Recording is corrupt at byte %ld\n", (long)(pos - data));
+	exit(1);
+}
+
+static unsigned long getVarint(void) {
+	unsigned long n = 0;
+	int shift = 0;
+
+	do {
+		if(pos >= end || shift > 56) corrupt();
+		n |= (unsigned long)(*pos & 0x7f) << shift;
+		shift += 7;
+	} while(*pos++ & 0x80);
+	return n;
+}
+
+static long getSigned(void) {
+	unsigned long n = getVarint();
+	return (n & 1) ? -(long)(n >> 1) - 1 : (long)(n >> 1);
+}
+
+static double getDouble(void) {
+	Uint64 bits = 0;
+	double d;
+	int i;
+
+	if(end - pos < 8) corrupt();
+	for(i=0; i<8; i++)
+		bits |= (Uint64)*pos++ << (8*i);
+	memcpy(&d, &bits, 8);
+	return d;
+}
+
+static void getPoint(double *x, double *y) {
+	qx += getSigned();
+	qy += getSigned();
+	*x = xmin + (xmax-xmin) * qx / (double)(1L << REC_QBITS);
+	*y = ymin + (ymax-ymin) * qy / (double)(1L << REC_QBITS);
+}
+
+//map the whole file into memory
+static void load(const char *filename, size_t *size) {
+	struct stat st;
+	int fd;
+
+	fd = open(filename, O_RDONLY | O_BINARY);
+	if(fd < 0 || fstat(fd, &st) < 0) {
+		perror(filename);
+		exit(1);
+	}
+	*size = st.st_size;
+#ifdef _WIN32
+	//no mmap here, just read it
+	data = malloc(*size);
+	if(data == NULL || read(fd, (void *)data, *size) != (int)*size) {
+		perror(filename);
+		exit(1);
+	}
+#else
+	data = mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if(data == MAP_FAILED) {
+		perror(filename);
+		exit(1);
+	}
+#endif
+	close(fd);
+
+	if(*size < 5 || memcmp(data, REC_MAGIC, 4) != 0) {
+		fprintf(stderr, "%s isn't a draw call recording\n", filename);
+		exit(1);
+	}
+	if(data[4] < 1 || data[4] > REC_VERSION) {
+		fprintf(stderr, "%s is version %d, but I only know up to version %d\n", filename, data[4], REC_VERSION);
+		exit(1);
+	}
+}
+
+//returns 0 if the user closed the window
+static int pollQuit(void) {
+	SDL_Event ev;
+
+	while(SDL_PollEvent(&ev)) {
+		if(ev.type == SDL_QUIT) return 0;
+		if(ev.type == SDL_KEYDOWN && (ev.key.keysym.sym == SDLK_ESCAPE || ev.key.keysym.sym == SDLK_q)) return 0;
+	}
+	return 1;
+}
+
+int main(int argc, char **argv) {
+	const char *filename = NULL;
+	int realtime = 0, simplify = 0, stabilize = 0, interpolate = 0, loops = 1, loop, running = 1;
+	long frames = 0, points = 0;
+	double refreshSum = 0, x, y, x1, y1, x2, y2, w;
+	Uint32 start, elapsed;
+	unsigned long ms;
+	size_t size;
+	int i, op, id;
+
+	for(i=1; i<argc; i++) {
+		if(!strcmp(argv[i], "-backend") && i+1 < argc) gfxSelectBackend(argv[++i]);
+		else if(!strcmp(argv[i], "-realtime")) realtime = 1;
+		else if(!strcmp(argv[i], "-simplify")) simplify = 1;
+		else if(!strcmp(argv[i], "-stabilize") && i+1 < argc) stabilize = atoi(argv[++i]);
+		else if(!strcmp(argv[i], "-interpolate")) interpolate = 1;
+		else if(!strcmp(argv[i], "-loop") && i+1 < argc) loops = atoi(argv[++i]);
+		else filename = argv[i];
+	}
+	if(filename == NULL) {
+		fprintf(stderr, "Usage: %s [-backend name] [-realtime] [-simplify] [-stabilize N] [-interpolate] [-loop N] recording.vrec\n", argv[0]);
+		return 1;
+	}
+
+	load(filename, &size);
+
+	if(SDL_Init(SDL_INIT_VIDEO) != 0) {
+		fprintf(stderr, "Unable to initialize SDL: %s\n", SDL_GetError());
+		exit(1);
+	}
+	atexit(SDL_Quit);
+	gfxInit(44100, 1024);
+	setSimplify(simplify);
+	setStabilize(stabilize);
+	setInterpolate(interpolate);
+
+	start = SDL_GetTicks();
+	for(loop=0; loop<loops && running; loop++) {
+		pos = data + 5;
+		end = data + size;
+		qx = qy = 0;
+		weight = 0;
+
+		while(pos < end && running) {
+			op = *pos++;
+			switch(op) {
+				case OP_MOVE:
+					getPoint(&x, &y);
+					moveTo(x, y);
+					points++;
+					break;
+				case OP_LINEW:
+					weight = getVarint() / (double)REC_WSCALE;
+					//fall through
+				case OP_LINE:
+					getPoint(&x, &y);
+					lineTo(x, y, weight);
+					points++;
+					break;
+				case OP_CUBIC:
+					w = getVarint() / (double)REC_WSCALE;
+					getPoint(&x1, &y1);
+					getPoint(&x2, &y2);
+					getPoint(&x, &y);
+					cubicTo(x1, y1, x2, y2, x, y, w);
+					points += 3;
+					break;
+				case OP_FLIP:
+				case OP_FLIPC:
+					ms = getVarint();
+					//ms is how long the game took to get to this flip, so wait before it
+					if(realtime) SDL_Delay(ms);
+					flip(op == OP_FLIPC);
+					frames++;
+					refreshSum += getRefreshRate();
+					running = pollQuit();
+					break;
+				case OP_MODE:
+					setMode((int)getVarint());
+					break;
+				case OP_WRAP:
+					setWrap((int)getVarint());
+					break;
+				case OP_OBJECT:
+					id = (int)getSigned();
+					getPoint(&x, &y);
+					beginObject(id, x, y, getDouble());
+					break;
+				case OP_ENDOBJ:
+					endObject();
+					break;
+				case OP_SCALE:
+					xmin = getDouble();
+					xmax = getDouble();
+					ymin = getDouble();
+					ymax = getDouble();
+					setScale(xmin, xmax, ymin, ymax, getDouble());
+					break;
+				default:
+					pos--;
+					corrupt();
+			}
+		}
+	}
+	elapsed = SDL_GetTicks() - start;
+
+	printf("%ld frames, %ld points in %u ms\n", frames, points, elapsed);
+	if(frames > 0) {
+		printf("%.3f ms per frame, %.1f points per frame", elapsed/(double)frames, points/(double)frames);
+		if(refreshSum > 0) printf(", %.1f Hz average refresh", refreshSum/frames);
+		printf("\n");
+	}
+	return 0;
+}
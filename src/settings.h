@@ -0,0 +1,46 @@
+/* The game's settings
+ *
+ * Easily-changed game parameters, in one place so the bench program
+ * (bench.c) plays its scenes with exactly the settings the game has.
+ *
+ * I'm releasing this code under the WTFPL. You can do whatever you like with
+ * it, though I'd appreciate credit and thanks if you find it useful or fun.
+ * See LICENSE.txt for details.
+ *            -Joe McKenzie / Chupi
+ */
+
+#ifndef __SETTINGS_H__
+#define __SETTINGS_H__
+
+#define PI 3.14159265358979323846
+
+#define SAFE_ZONE 150	//radius of safe zone around player where new asteroids won't appear
+#define DRAG 0.25	//slowdown rate of player ship
+#define THRUST 1.0	//player ship thruster power
+#define SPIN (PI/16)	//player ship spin rate
+#define MAX_ROIDS 32	//maximum asteroids on screen at once
+#define INIT_ROIDS 4	//number of asteroids to generate initially
+#define ROID_SPEED 3	//maximum speed for a big asteroid - smaller ones may move faster
+#define MAX_BULLETS 5	//maximum bullets on screen
+#define BULLET_SPEED 15.0	//bullet flight speed
+#define BULLET_RANGE 500	//the screen is 1000 wide and 1000 high
+#define RAPIDFIRE_ENABLE 1	//allow rapidfire by holding space?
+#define RAPIDFIRE_DELAY 5	//frames between rapidfire shots
+#define ROID_RESPAWN_THRESHOLD 5	//make new asteroids when there are fewer than this
+#define ROID_RESPAWN_DELAY 40	//min frames between asteroid respawns (currently 20 frames/sec)
+#define ROID_RESPAWN_RATE 0.6	//probability an asteroid will respawn after ROID_RESPAWN_DELAY
+#define MAX_FRAGMENTS 4	//params for the debris that appears when you die
+#define FRAGMENT_MIN_AGE 15
+#define FRAGMENT_MAX_AGE 25
+#define HUD_SIZE 30	//height of score text
+#define HUD_BRIGHT 0.6	//brightness of score text
+#define ROID_ANGLE_STEPS 256	//asteroid rotation steps to cache points for (0 = don't cache)
+#ifndef NOBOX
+#define STABILIZE_SAMPLES 400	//samples of drawing between the borders that steady the picture (see setStabilize)
+#else
+#define STABILIZE_SAMPLES 0
+#endif
+#define MODEL_CHECK_TICKS 10	//ticks between looks at the model file for changes
+#define FREQ 44100	//sound card sample rate
+
+#endif
@@ -0,0 +1,140 @@
+/* Example consumer for the shared memory frame ring (see gfx_shm.h)
+ *
+ * Reads frames published by asteroids-shm and writes raw PCM to stdout:
+ * interleaved signed 16-bit native-endian stereo at the sample rate in the
+ * ring header. Nothing is copied out of the ring; samples are written straight
+ * from shared memory.
+ *
+ * Usage: shm-consumer [-r] [name]
+ *   default: loop the newest frame forever, like the sound card does in the
+ *            normal scope version. Pipe it into something that plays raw audio:
+ *              ./shm-consumer | aplay -f S16_LE -c 2 -r 44100
+ *   -r: record mode; write every frame exactly once, in order, for capturing
+ *       a session to a file. Frames the producer laps before we get to them are
+ *       counted as missed.
+ *   name: shared memory object name, default ASTEROIDS_SHM or /asteroids-scope
+ *
+ * I'm releasing this code under the WTFPL. You can do whatever you like with
+ * it, though I'd appreciate credit and thanks if you find it useful or fun.
+ * See LICENSE.txt for details.
+ *            -Joe McKenzie / Chupi
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "gfx_shm.h"
+
+static volatile int running = 1;
+
+static void stop(int sig) {
+	running = 0;
+}
+
+//map the ring read-only, waiting for the producer to create it if needed
+static struct shm_header *attach(const char *name, size_t *size) {
+	struct shm_header *hdr;
+	struct stat st;
+	int fd, waited = 0;
+
+	while(running) {
+		fd = shm_open(name, O_RDONLY, 0);
+		if(fd >= 0 && fstat(fd, &st) == 0 && st.st_size >= (off_t)sizeof(struct shm_header)) {
+			hdr = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+			close(fd);
+			if(hdr == MAP_FAILED) {
+				perror("Couldn't map shared memory");
+				exit(1);
+			}
+			if(hdr->magic == SHM_MAGIC) {
+				if(hdr->version != SHM_VERSION) {
+					fprintf(stderr, "%s is version %u, but I only know version %d\n", name, hdr->version, SHM_VERSION);
+					exit(1);
+				}
+				if((off_t)SHM_TOTAL_BYTES(hdr->nslots, hdr->slotSamples) > st.st_size) {
+					fprintf(stderr, "%s is smaller than its header says\n", name);
+					exit(1);
+				}
+				*size = st.st_size;
+				return hdr;
+			}
+			munmap(hdr, st.st_size);
+		} else if(fd >= 0) close(fd);
+
+		if(!waited++) fprintf(stderr, "Waiting for %s to appear . . .\n", name);
+		usleep(100000);
+	}
+	return NULL;
+}
+
+int main(int argc, char **argv) {
+	struct shm_header *hdr;
+	struct shm_slot *slot;
+	const char *name = NULL;
+	size_t size;
+	uint32_t seq, cur = 0;
+	long frames = 0, missed = 0, torn = 0;
+	int record = 0, i;
+
+	for(i=1; i<argc; i++) {
+		if(!strcmp(argv[i], "-r")) record = 1;
+		else name = argv[i];
+	}
+	if(name == NULL) name = getenv("ASTEROIDS_SHM");
+	if(name == NULL || !*name) name = SHM_DEFAULT_NAME;
+
+	signal(SIGINT, stop);
+	signal(SIGTERM, stop);
+	signal(SIGPIPE, stop);
+
+	hdr = attach(name, &size);
+	if(hdr == NULL) return 0;
+	fprintf(stderr, "Attached to %s: %u Hz, %u slots of %u samples\n", name, hdr->sampleRate, hdr->nslots, hdr->slotSamples);
+
+	while(running && hdr->magic == SHM_MAGIC) {
+		seq = hdr->seq;
+		__sync_synchronize();
+
+		if(record) {
+			//next frame in order, or skip ahead if the producer lapped us
+			if(seq == cur) {
+				usleep(1000);
+				continue;
+			}
+			if(seq - cur > hdr->nslots) {
+				if(cur != 0) missed += seq - cur - hdr->nslots;
+				cur = seq - hdr->nslots;
+			}
+			cur++;
+		} else {
+			//newest frame, or keep looping the one we have
+			if(seq == 0) {
+				usleep(1000);
+				continue;
+			}
+			cur = seq;
+		}
+
+		slot = SHM_SLOT(hdr, cur % hdr->nslots);
+		if(slot->seq != cur) {
+			//being rewritten right now
+			if(record) missed++;
+			continue;
+		}
+		__sync_synchronize();
+		if(fwrite(SHM_SAMPLES(slot), 4, slot->n, stdout) != slot->n) break;
+		__sync_synchronize();
+		if(slot->seq != cur) torn++;
+		frames++;
+	}
+
+	fflush(stdout);
+	fprintf(stderr, "Wrote %ld frames, %ld missed, %ld torn\n", frames, missed, torn);
+	munmap(hdr, size);
+	return 0;
+}
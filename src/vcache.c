@@ -0,0 +1,105 @@
+/* Cache of pre-rotated, pre-scaled model points (see vcache.h)
+ *
+ * I'm releasing this code under the WTFPL. You can do whatever you like with
+ * it, though I'd appreciate credit and thanks if you find it useful or fun.
+ * See LICENSE.txt for details.
+ *            -Joe McKenzie / Chupi
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <limits.h>
+#include <stdint.h>
+#include "vcache.h"
+
+#define PI 3.14159265358979323846
+
+void vcacheInit(struct vcache *vc, const struct model *models, int nmodels, const double *scales, int nscales, int buckets) {
+	size_t perBucket;	//floats for every model and scale at one angle
+	int i, entries;
+
+	memset(vc, 0, sizeof(struct vcache));
+	vc->models = models;
+	vc->nmodels = nmodels;
+	vc->scales = scales;
+	vc->nscales = nscales;
+	if(buckets <= 0) return;
+
+	for(i=0; i<nmodels; i++)
+		if(models[i].n > vc->maxPts) vc->maxPts = models[i].n;
+
+	//every point of every entry has to be countable in an int, or the sizes
+	//below (and the offsets in vcacheGet) wrap around
+	perBucket = (size_t)nmodels * nscales * vc->maxPts * 2;
+	if(perBucket == 0) return;
+	if((size_t)buckets > INT_MAX / perBucket || (size_t)buckets > SIZE_MAX / sizeof(vc->pts[0]) / perBucket) {
+		fprintf(stderr, "vcacheInit: %d angle steps is too many, not caching\n", buckets);
+		return;
+	}
+	entries = nmodels * nscales * buckets;
+	vc->pts = malloc((size_t)entries * vc->maxPts * 2 * sizeof(vc->pts[0]));
+	vc->filled = calloc(entries, 1);
+	if(vc->pts == NULL || vc->filled == NULL) {
+		fprintf(stderr, "vcacheInit: out of memory, not caching\n");
+		vcacheFree(vc);
+		return;
+	}
+	vc->buckets = buckets;
+}
+
+const float *vcacheGet(struct vcache *vc, int model, int scale, double angle) {
+	const struct model *m;
+	float *pts;
+	double c, s, r;
+	int b, i, entry;
+
+	if(vc->buckets <= 0) return NULL;
+
+	//nearest bucket, wrapped into 0..buckets-1 whichever way angle is out of range
+	b = (int)floor(angle * vc->buckets / (2*PI) + 0.5) % vc->buckets;
+	if(b < 0) b += vc->buckets;
+
+	entry = (model*vc->nscales + scale)*vc->buckets + b;
+	pts = vc->pts + entry * vc->maxPts * 2;
+	if(vc->filled[entry]) {
+		vc->hits++;
+		return pts;
+	}
+
+	//first time we've seen this one, rotate it at the bucket's angle
+	vc->misses++;
+	m = &vc->models[model];
+	r = vc->scales[scale];
+	c = r * cos(b * 2*PI / vc->buckets);
+	s = r * sin(b * 2*PI / vc->buckets);
+	for(i=0; i<m->n; i++) {
+		pts[2*i+0] = (float)(m->xy[2*i]*c - m->xy[2*i+1]*s);
+		pts[2*i+1] = (float)(m->xy[2*i]*s + m->xy[2*i+1]*c);
+	}
+	vc->filled[entry] = 1;
+	return pts;
+}
+
+void vcacheReport(const struct vcache *vc, const char *name, FILE *f) {
+	long lookups = vc->hits + vc->misses;
+	int entries, used = 0, i;
+
+	if(vc->buckets <= 0) return;
+
+	entries = vc->nmodels * vc->nscales * vc->buckets;
+	for(i=0; i<entries; i++) used += vc->filled[i];
+	fprintf(f, "%s cache: %d angle steps, %d of %d entries used, %ld KB allocated, %ld lookups, %.1f%% hits\n",
+		name, vc->buckets, used, entries,
+		(long)(entries * (vc->maxPts * 2 * sizeof(vc->pts[0]) + 1) + 1023) / 1024,
+		lookups, lookups ? 100.0 * vc->hits / lookups : 0.0);
+}
+
+void vcacheFree(struct vcache *vc) {
+	free(vc->pts);
+	free(vc->filled);
+	vc->pts = NULL;
+	vc->filled = NULL;
+	vc->buckets = 0;
+}
@@ -0,0 +1,55 @@
+/* Cache of pre-rotated, pre-scaled model points
+ *
+ * Asteroids spin all the time, so every frame each one would need all its
+ * points rotated again. Instead, the circle is split into a fixed number of
+ * angle buckets, and the first time a (model, size, bucket) combination is
+ * drawn, its rotated and scaled points are saved. After that, drawing it is
+ * just adding the asteroid's position to each saved point.
+ *
+ * With 256 buckets, angles are rounded to 1.4 degrees, which you can't see on
+ * a scope at 20 game frames per second.
+ *
+ * I'm releasing this code under the WTFPL. You can do whatever you like with
+ * it, though I'd appreciate credit and thanks if you find it useful or fun.
+ * See LICENSE.txt for details.
+ *            -Joe McKenzie / Chupi
+ */
+
+#ifndef __VCACHE_H__
+#define __VCACHE_H__
+
+#include <stdio.h>
+#include "asteroids_models.h"
+
+struct vcache {
+	const struct model *models;	//shapes being cached
+	int nmodels;
+	const double *scales;	//sizes being cached
+	int nscales;
+	int buckets;	//angle steps per full turn
+	int maxPts;	//room for this many points in each entry
+	float *pts;	//all entries, maxPts x,y pairs each
+	unsigned char *filled;	//whether each entry has been computed yet
+	long hits, misses;
+};
+
+/* vcacheInit: set up a cache for every combination of models and scales
+ *   buckets: number of angle steps in a full turn. If 0 or less, the cache is
+ *   disabled and vcacheGet always returns NULL. It's also disabled, with a
+ *   message, if there are too many to allocate.
+ *   Entries are computed when first used, but the memory for all of them is
+ *   allocated here.                                                          */
+extern void vcacheInit(struct vcache *vc, const struct model *models, int nmodels, const double *scales, int nscales, int buckets);
+
+/* vcacheGet: get points of models[model] scaled by scales[scale] and rotated
+ *   by angle (rounded to the nearest bucket), relative to the model's center.
+ *   Returns models[model].n x,y pairs, or NULL if the cache is disabled.     */
+extern const float *vcacheGet(struct vcache *vc, int model, int scale, double angle);
+
+/* vcacheReport: print memory use and hit rate                                */
+extern void vcacheReport(const struct vcache *vc, const char *name, FILE *f);
+
+/* vcacheFree: release the cache's memory                                     */
+extern void vcacheFree(struct vcache *vc);
+
+#endif
@@ -0,0 +1,171 @@
+/* Vector font for drawing text on the scope (see vfont.h)
+ *
+ * I'm releasing this code under the WTFPL. You can do whatever you like with
+ * it, though I'd appreciate credit and thanks if you find it useful or fun.
+ * See LICENSE.txt for details.
+ *            -Joe McKenzie / Chupi
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "gfx.h"
+#include "vfont.h"
+
+//glyphs are on a grid 4 wide and 6 tall, top left is 0,0
+#define GLYPH_W 4
+#define GLYPH_H 6
+#define GLYPH_ADVANCE 6	//width plus gap
+
+//Each glyph is a string of strokes separated by spaces. Each stroke is a list
+//of points, each point 2 digits: x then y. So "0040 2026" is a line from 0,0
+//to 4,0, then a jump to 2,0 and a line to 2,6 (a T).
+//Strokes are ordered so each one starts near where the last one ended.
+static const char *glyphs[128] = {
+	['0'] = "004046060046",
+	['1'] = "112026",
+	['2'] = "004043030646",
+	['3'] = "00404606 1343",
+	['4'] = "000343 4046",
+	['5'] = "400003434606",
+	['6'] = "400006464303",
+	['7'] = "004046",
+	['8'] = "0040460600 0343",
+	['9'] = "430300404606",
+	['A'] = "060110304146 0343",
+	['B'] = "00304142334445360600 0333",
+	['C'] = "40000646",
+	['D'] = "00304145360600",
+	['E'] = "40000646 0333",
+	['F'] = "400006 0333",
+	['G'] = "400006464323",
+	['H'] = "0600 0343 4046",
+	['I'] = "0040 2026 0646",
+	['J'] = "4045361605",
+	['K'] = "0006 400346",
+	['L'] = "000646",
+	['M'] = "0600234046",
+	['N'] = "06004640",
+	['O'] = "0040460600",
+	['P'] = "0600404303",
+	['Q'] = "0040460600 2446",
+	['R'] = "060040430346",
+	['S'] = "400003434606",
+	['T'] = "0040 2026",
+	['U'] = "00064640",
+	['V'] = "002640",
+	['W'] = "0006234640",
+	['X'] = "0046 4006",
+	['Y'] = "002340 2326",
+	['Z'] = "00400646",
+	['-'] = "0343",
+};
+
+//a string after layout: points in screen coordinates, and whether to draw a line to each one
+struct laidOut {
+	char str[TEXT_MAX_LEN+1];
+	double x, y, size;
+	int n;
+	float pts[TEXT_MAX_LEN * 24 * 2];	//the most points a glyph has is 12, twice for pen-up ends
+	unsigned char line[TEXT_MAX_LEN * 24];
+};
+
+//recently drawn strings; replaced round-robin
+#define TEXT_CACHE 4
+static struct laidOut cache[TEXT_CACHE];
+static int cacheNext = 0;
+
+static const char *glyphFor(char c) {
+	if(c >= 'a' && c <= 'z') c += 'A' - 'a';
+	if(c < 0 || glyphs[(int)c] == NULL) return "";
+	return glyphs[(int)c];
+}
+
+static void addPt(struct laidOut *lo, double x, double y, int line) {
+	lo->pts[2*lo->n+0] = (float)x;
+	lo->pts[2*lo->n+1] = (float)y;
+	lo->line[lo->n] = line;
+	lo->n++;
+}
+
+//append glyph g at gx,gy, traced forward or backward; leaves the pen at its last point
+static void layGlyph(struct laidOut *lo, const char *g, double gx, double gy, double unit, int backward) {
+	int len = strlen(g), i, step, pen = 0;
+
+	//walking backward through the string also reverses each stroke
+	i = backward ? len-2 : 0;
+	step = backward ? -2 : 2;
+	while(i >= 0 && i < len) {
+		if(g[i] == ' ' || (backward && i+1 < len && g[i+1] == ' ')) {
+			//end of stroke, next point is a jump
+			pen = 0;
+			i += backward ? -1 : 1;
+			continue;
+		}
+		addPt(lo, gx + unit*(g[i]-'0'), gy + unit*(g[i+1]-'0'), pen);
+		pen = 1;
+		i += step;
+	}
+}
+
+static double dist2(double x0, double y0, double x1, double y1) {
+	return (x1-x0)*(x1-x0) + (y1-y0)*(y1-y0);
+}
+
+//lay out a whole string in one pass
+static void layout(struct laidOut *lo, const char *str, double x, double y, double size) {
+	double unit = size / GLYPH_H, gx, penX = x, penY = y;
+	const char *g;
+	int i, len;
+
+	snprintf(lo->str, sizeof(lo->str), "%s", str);
+	lo->x = x;
+	lo->y = y;
+	lo->size = size;
+	lo->n = 0;
+
+	for(i=0; lo->str[i]; i++) {
+		g = glyphFor(lo->str[i]);
+		if(!*g) continue;
+		gx = x + i*GLYPH_ADVANCE*unit;
+		len = strlen(g);
+
+		//start from whichever end of the glyph is closer to the beam
+		layGlyph(lo, g, gx, y, unit,
+			dist2(penX, penY, gx + unit*(g[len-2]-'0'), y + unit*(g[len-1]-'0')) <
+			dist2(penX, penY, gx + unit*(g[0]-'0'), y + unit*(g[1]-'0')));
+		penX = lo->pts[2*lo->n-2];
+		penY = lo->pts[2*lo->n-1];
+	}
+}
+
+void drawText(const char *str, double x, double y, double size, double bright) {
+	struct laidOut *lo = NULL;
+	int i;
+
+	//already laid out?
+	for(i=0; i<TEXT_CACHE; i++) {
+		if(cache[i].size == size && cache[i].x == x && cache[i].y == y && !strncmp(cache[i].str, str, TEXT_MAX_LEN)) {
+			lo = &cache[i];
+			break;
+		}
+	}
+	if(lo == NULL) {
+		lo = &cache[cacheNext];
+		cacheNext = (cacheNext+1) % TEXT_CACHE;
+		layout(lo, str, x, y, size);
+	}
+
+	for(i=0; i<lo->n; i++) {
+		if(lo->line[i]) lineTo(lo->pts[2*i], lo->pts[2*i+1], bright);
+		else moveTo(lo->pts[2*i], lo->pts[2*i+1]);
+	}
+}
+
+double textWidth(const char *str, double size) {
+	int len = strlen(str);
+
+	if(len > TEXT_MAX_LEN) len = TEXT_MAX_LEN;
+	if(len == 0) return 0;
+	return size / GLYPH_H * ((len-1)*GLYPH_ADVANCE + GLYPH_W);
+}
@@ -0,0 +1,37 @@
+/* Vector font for drawing text on the scope
+ *
+ * Covers digits, A-Z (lowercase is drawn as uppercase), space and '-'. Other
+ * characters are drawn as spaces.
+ *
+ * Every point the beam visits costs samples and lowers the refresh rate of
+ * the whole picture, so the glyphs are blocky and made of as few strokes as
+ * possible. Each glyph is stored as a precompiled list of strokes (connected
+ * lines), already ordered so the jumps between strokes are short. When a
+ * string is laid out, each glyph is traced forwards or backwards, whichever
+ * starts closer to where the previous glyph ended.
+ *
+ * Laid-out strings are cached, so redrawing text that hasn't changed since the
+ * last frame (like the score) is just replaying its points.
+ *
+ * I'm releasing this code under the WTFPL. You can do whatever you like with
+ * it, though I'd appreciate credit and thanks if you find it useful or fun.
+ * See LICENSE.txt for details.
+ *            -Joe McKenzie / Chupi
+ */
+
+#ifndef __VFONT_H__
+#define __VFONT_H__
+
+#define TEXT_MAX_LEN 32	//longer strings are cut off
+
+/* drawText: draw a string using moveTo/lineTo
+ *   x, y: top left corner of the first character
+ *   size: height of a character in screen units. Characters are 2/3 as wide,
+ *     plus 1/3 for the gap between them.
+ *   bright: weight passed to lineTo                                          */
+extern void drawText(const char *str, double x, double y, double size, double bright);
+
+/* textWidth: width a string will take up at the given size                  */
+extern double textWidth(const char *str, double size);
+
+#endif
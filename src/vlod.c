@@ -0,0 +1,151 @@
+/* Simpler versions of models, for busy screens (see vlod.h)
+ *
+ * I'm releasing this code under the WTFPL. You can do whatever you like with
+ * it, though I'd appreciate credit and thanks if you find it useful or fun.
+ * See LICENSE.txt for details.
+ *            -Joe McKenzie / Chupi
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "vlod.h"
+
+//how far each level's points may stray from the model's, in nominal radii
+static const double tolerance[LOD_LEVELS] = {0, 0.1, 0.25, 0.4};
+
+//how far things may stray in screen units: always this much, which is less than the beam's spot...
+#define LOD_MIN_ERROR 1.5
+//...up to this much, as frames go from LOD_LOAD_LOW to LOD_LOAD_HIGH of the samples they can have
+#define LOD_MAX_ERROR 8.0
+#define LOD_LOAD_LOW 0.8
+#define LOD_LOAD_HIGH 1.2
+
+//distance from point p to the line segment a-b
+static double segmentDistance(const float *p, const float *a, const float *b) {
+	double dx = b[0]-a[0], dy = b[1]-a[1], len2 = dx*dx + dy*dy, t;
+
+	if(len2 == 0) return hypot(p[0]-a[0], p[1]-a[1]);
+	t = ((p[0]-a[0])*dx + (p[1]-a[1])*dy) / len2;
+	if(t < 0) t = 0;
+	else if(t > 1) t = 1;
+	return hypot(p[0]-a[0]-t*dx, p[1]-a[1]-t*dy);
+}
+
+//Douglas-Peucker: keep the point between a and b farthest from the line a-b if it's more than tol
+//away, and do the same on each side of it; returns the farthest any dropped point is from the line
+static double simplify(const float *xy, int a, int b, double tol, char *keep) {
+	double d, far = 0, e1, e2;
+	int i, f = -1;
+
+	for(i=a+1; i<b; i++) {
+		d = segmentDistance(&xy[2*i], &xy[2*a], &xy[2*b]);
+		if(d > far) {
+			far = d;
+			f = i;
+		}
+	}
+	if(f < 0 || far <= tol) return far;
+	keep[f] = 1;
+	e1 = simplify(xy, a, f, tol, keep);
+	e2 = simplify(xy, f, b, tol, keep);
+	return e1 > e2 ? e1 : e2;
+}
+
+void vlodInit(struct vlod *vl, const struct model *models, int nmodels) {
+	const struct model *m;
+	struct model *v;
+	char *keep;
+	float *out;
+	int i, j, k, level, total = 0, maxPts = 0, minPts;
+
+	memset(vl, 0, sizeof(struct vlod));
+	for(i=0; i<nmodels; i++) {
+		total += models[i].n;
+		if(models[i].n > maxPts) maxPts = models[i].n;
+	}
+	vl->models = malloc(nmodels * LOD_LEVELS * sizeof(struct model));
+	vl->error = malloc(nmodels * LOD_LEVELS * sizeof(vl->error[0]));
+	vl->xy = malloc(((LOD_LEVELS-1) * total * 2 + 1) * sizeof(vl->xy[0]));
+	keep = malloc(maxPts + 1);
+	if(vl->models == NULL || vl->error == NULL || vl->xy == NULL || keep == NULL) {
+		fprintf(stderr, "vlodInit: out of memory\n");
+		exit(1);
+	}
+	vl->nmodels = nmodels;
+
+	out = vl->xy;
+	for(i=0; i<nmodels; i++) {
+		m = &models[i];
+		v = &vl->models[i*LOD_LEVELS];
+		v[0] = *m;
+		vl->error[i*LOD_LEVELS] = 0;
+		//a closed shape has to stay a shape, not collapse into a line
+		minPts = m->n > 3 && m->xy[0] == m->xy[2*(m->n-1)] && m->xy[1] == m->xy[2*(m->n-1)+1] ? 4 : 2;
+
+		for(level=1; level<LOD_LEVELS; level++) {
+			v[level] = v[level-1];
+			vl->error[i*LOD_LEVELS + level] = vl->error[i*LOD_LEVELS + level-1];
+			if(m->n <= minPts) continue;
+
+			memset(keep, 0, m->n);
+			keep[0] = keep[m->n-1] = 1;
+			vl->error[i*LOD_LEVELS + level] = simplify(m->xy, 0, m->n-1, tolerance[level], keep);
+			for(j=0, k=0; j<m->n; j++) k += keep[j];
+			if(k < minPts) {
+				//too simple: make do with the level before
+				vl->error[i*LOD_LEVELS + level] = vl->error[i*LOD_LEVELS + level-1];
+				continue;
+			}
+
+			v[level].xy = out;
+			v[level].n = k;
+			v[level].strokes = k-1;
+			for(j=0; j<m->n; j++)
+				if(keep[j]) {
+					*out++ = m->xy[2*j];
+					*out++ = m->xy[2*j+1];
+				}
+		}
+	}
+	free(keep);
+}
+
+double vlodAllowed(double samples, int freq, double hz) {
+	double load = samples * hz / freq;
+
+	if(hz <= 0) return 0;
+	if(load <= LOD_LOAD_LOW) return LOD_MIN_ERROR;
+	if(load >= LOD_LOAD_HIGH) return LOD_MAX_ERROR;
+	return LOD_MIN_ERROR + (LOD_MAX_ERROR-LOD_MIN_ERROR) * (load-LOD_LOAD_LOW) / (LOD_LOAD_HIGH-LOD_LOAD_LOW);
+}
+
+int vlodPick(struct vlod *vl, int model, double radius, double allowed) {
+	int level;
+
+	for(level=LOD_LEVELS-1; level>0; level--)
+		if(vl->error[model*LOD_LEVELS + level] * radius <= allowed) break;
+	//a level that didn't drop any more points than the one before isn't worth having
+	while(level > 0 && vl->models[model*LOD_LEVELS + level].n == vl->models[model*LOD_LEVELS + level-1].n) level--;
+	vl->picked[level]++;
+	return model*LOD_LEVELS + level;
+}
+
+void vlodReport(const struct vlod *vl, const char *name, FILE *f) {
+	long drawn = 0;
+	int level;
+
+	for(level=0; level<LOD_LEVELS; level++) drawn += vl->picked[level];
+	if(drawn == 0) return;
+	fprintf(f, "%s detail: %ld drawn, at each level from full to simplest:", name, drawn);
+	for(level=0; level<LOD_LEVELS; level++) fprintf(f, " %.1f%%", 100.0*vl->picked[level]/drawn);
+	fprintf(f, "\n");
+}
+
+void vlodFree(struct vlod *vl) {
+	free(vl->models);
+	free(vl->error);
+	free(vl->xy);
+	memset(vl, 0, sizeof(struct vlod));
+}
@@ -0,0 +1,63 @@
+/* Simpler versions of models, for busy screens
+ *
+ * Every line costs the beam at least a couple of samples however short it
+ * is, so a small asteroid takes nearly as long to draw as a big one, and a
+ * screen full of them refreshes slowly enough to flicker. This makes
+ * LOD_LEVELS variants of each model: the model itself, then simpler and
+ * simpler ones made by dropping the points that matter least (Douglas-
+ * Peucker). It works them out when it starts, from whatever models it's
+ * given, so shapes from a model file (see vmodel.h) get them too.
+ *
+ * Which variant to draw depends on how big the object is on the screen, and
+ * on how busy the screen has been lately. Detail nobody could see is always
+ * dropped. As the frames get close to the most samples they can have and
+ * still refresh at the rate wanted, more goes, small things first, since
+ * their points stray the least in screen units.
+ *
+ * I'm releasing this code under the WTFPL. You can do whatever you like with
+ * it, though I'd appreciate credit and thanks if you find it useful or fun.
+ * See LICENSE.txt for details.
+ *            -Joe McKenzie / Chupi
+ */
+
+#ifndef __VLOD_H__
+#define __VLOD_H__
+
+#include <stdio.h>
+#include "asteroids_models.h"
+
+#define LOD_LEVELS 4	//variants of each model, counting the model itself
+#define LOD_HZ 50	//refresh rate busy screens are kept to by default
+
+struct vlod {
+	struct model *models;	//LOD_LEVELS variants of each model in a row, the model itself first
+	float *error;	//how far each variant strays from its model, in nominal radii
+	float *xy;	//the points of the simplified variants
+	int nmodels;
+	long picked[LOD_LEVELS];	//how many times each level has been drawn
+};
+
+/* vlodInit: work out the variants of nmodels models. The models must stay
+ *   where they are until vlodFree, since the first variant of each is it.    */
+extern void vlodInit(struct vlod *vl, const struct model *models, int nmodels);
+
+/* vlodAllowed: how far from its real shape anything drawn this frame may
+ *   stray, in screen units (the units of drawObj's radius). Goes up as
+ *   samples, the samples frames have had lately (from getBeamStats, say),
+ *   gets close to too many to refresh at hz with the sound card running at
+ *   freq. 0 if hz is 0 or less, so only points that make no difference at
+ *   all are left out.                                                        */
+extern double vlodAllowed(double samples, int freq, double hz);
+
+/* vlodPick: the variant of models[model] to draw at radius, the simplest that
+ *   strays no more than allowed (from vlodAllowed). Returns its index in
+ *   vl->models, which is also its index for a vcache made from them.         */
+extern int vlodPick(struct vlod *vl, int model, double radius, double allowed);
+
+/* vlodReport: print how often each level was drawn                           */
+extern void vlodReport(const struct vlod *vl, const char *name, FILE *f);
+
+/* vlodFree: release the variants' memory                                     */
+extern void vlodFree(struct vlod *vl);
+
+#endif
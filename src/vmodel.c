@@ -0,0 +1,161 @@
+/* Model files: the game's shapes in a binary file (see vmodel.h)
+ *
+ * I'm releasing this code under the WTFPL. You can do whatever you like with
+ * it, though I'd appreciate credit and thanks if you find it useful or fun.
+ * See LICENSE.txt for details.
+ *            -Joe McKenzie / Chupi
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include "vmodel.h"
+#include "asteroids_models.h"
+
+//Windows opens files as text unless told not to
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+void vmodelBuiltin(struct modelSet *ms) {
+	memset(ms, 0, sizeof(struct modelSet));
+	ms->ship = &ship_model;
+	ms->flame = &flame_model;
+	ms->bullet = &bullet_model;
+	ms->roids = roid_models;
+	ms->nroids = nroid_models;
+	ms->logo = logo_models;
+	ms->nletters = logo_letters;
+}
+
+//read the whole file into memory of our own, so nothing done to the file
+//later (rewriting it in place, say) can touch the models; NULL if it can't be
+static void *readFile(const char *filename, struct stat *st) {
+	char *data;
+	long got = 0;
+	int fd, n;
+
+	fd = open(filename, O_RDONLY | O_BINARY);
+	if(fd < 0 || fstat(fd, st) < 0) {
+		perror(filename);
+		if(fd >= 0) close(fd);
+		return NULL;
+	}
+	data = malloc(st->st_size > 0 ? st->st_size : 1);
+	while(data != NULL && got < (long)st->st_size) {
+		n = read(fd, data+got, st->st_size-got);
+		if(n <= 0) break;
+		got += n;
+	}
+	if(data != NULL && got < (long)st->st_size) {
+		free(data);
+		data = NULL;
+	}
+	if(data == NULL) fprintf(stderr, "%s: couldn't read it\n", filename);
+	close(fd);
+	return data;
+}
+
+//the run of entries called name; returns the first, and how many there are in *n
+static int findSet(const struct vmodEntry *e, int nmodels, const char *name, int *n) {
+	int i;
+
+	for(i=0; i<nmodels && strcmp(e[i].name, name); i++);
+	for(*n=0; i+*n < nmodels && !strcmp(e[i+*n].name, name); (*n)++);
+	return i;
+}
+
+int vmodelLoad(struct modelSet *ms, const char *filename) {
+	static const char *needed[] = {"ship", "flame", "bullet", "roid", "logo"};
+	const struct vmodHeader *h;
+	const struct vmodEntry *e;
+	const float *pts;
+	struct model *models = NULL;
+	const char *problem = NULL;
+	int first[5], count[5];
+	struct stat st;
+	const void *data;
+	size_t size;
+	int i;
+
+	data = readFile(filename, &st);
+	if(data == NULL) return 0;
+	size = st.st_size;
+	h = data;
+	e = (const struct vmodEntry *)(h+1);
+
+	//everything has to fit exactly, before any of it is believed
+	if(size < sizeof(struct vmodHeader) || memcmp(h->magic, VMOD_MAGIC, 4))
+		problem = "isn't a model file";
+	else if(h->version != VMOD_VERSION)
+		problem = "is the wrong version, or from a machine with the other byte order";
+	else if(h->nmodels > size / sizeof(struct vmodEntry) || h->npoints > size / (2*sizeof(float)) ||
+			size != sizeof(struct vmodHeader) + h->nmodels*sizeof(struct vmodEntry) + h->npoints*2*sizeof(float))
+		problem = "is the wrong size for what it says is in it";
+	for(i=0; problem == NULL && i<(int)h->nmodels; i++) {
+		if(e[i].name[VMOD_NAME_LEN-1] != '\0') problem = "has a model with a bad name";
+		else if(e[i].n > h->npoints || e[i].first > h->npoints - e[i].n) problem = "has a model with points past the end";
+		else if(e[i].strokes >= e[i].n && e[i].n > 0) problem = "has a model with more lines than points";
+	}
+	for(i=0; problem == NULL && i<5; i++) {
+		first[i] = findSet(e, h->nmodels, needed[i], &count[i]);
+		if(count[i] == 0) problem = "is missing a ship, flame, bullet, roid or logo";
+	}
+
+	if(problem == NULL) {
+		//the models just point at the points where they are
+		pts = (const float *)(e + h->nmodels);
+		models = malloc(h->nmodels * sizeof(struct model));
+		if(models == NULL) problem = "is too big (out of memory)";
+		for(i=0; models != NULL && i<(int)h->nmodels; i++) {
+			models[i].xy = pts + 2*e[i].first;
+			models[i].n = e[i].n;
+			models[i].strokes = e[i].strokes;
+			models[i].radius = e[i].radius;
+		}
+	}
+	if(problem != NULL) {
+		fprintf(stderr, "%s %s\n", filename, problem);
+		free((void *)data);
+		return 0;
+	}
+
+	vmodelFree(ms);
+	ms->ship = &models[first[0]];
+	ms->flame = &models[first[1]];
+	ms->bullet = &models[first[2]];
+	ms->roids = &models[first[3]];
+	ms->nroids = count[3];
+	ms->logo = &models[first[4]];
+	ms->nletters = count[4];
+	ms->loaded = models;
+	ms->data = data;
+	ms->mtime = st.st_mtime;
+	ms->ino = (long)st.st_ino;
+	ms->bytes = (long)st.st_size;
+	return 1;
+}
+
+int vmodelReload(struct modelSet *ms, const char *filename) {
+	struct stat st;
+
+	//it may be missing for a moment while it's replaced
+	if(stat(filename, &st) < 0) return 0;
+	if(st.st_mtime == ms->mtime && (long)st.st_size == ms->bytes && (long)st.st_ino == ms->ino) return 0;
+	if(vmodelLoad(ms, filename)) return 1;
+
+	//keep the old models, and don't try this version of the file again
+	ms->mtime = st.st_mtime;
+	ms->ino = (long)st.st_ino;
+	ms->bytes = (long)st.st_size;
+	return 0;
+}
+
+void vmodelFree(struct modelSet *ms) {
+	free((void *)ms->data);
+	free(ms->loaded);
+	vmodelBuiltin(ms);
+}
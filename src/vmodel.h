@@ -0,0 +1,90 @@
+/* Model files: the game's shapes in a binary file, loaded without a rebuild
+ *
+ * Normally the shapes are compiled in from asteroids_models.h. A model file
+ * (.vmod) holds the same thing, laid out so it can be read straight into
+ * memory and drawn from there: nothing is parsed or converted, just checked.
+ * It's read rather than mapped, so that rewriting the file while the game is
+ * drawing from it can't pull the shapes out from under it.
+ * "mkmodels -vmod file.vmod" writes one from asteroids_objects.h ("make
+ * asteroids.vmod"), and the game loads one with -models file.vmod. While it
+ * runs, the game watches the file and picks up the new shapes whenever it's
+ * replaced, so art can be changed on a running game.
+ *
+ * The file is, in the byte order of the machine that wrote it:
+ *    struct vmodHeader
+ *    nmodels struct vmodEntry
+ *    npoints x,y pairs of floats, relative to each model's center and scaled
+ *      so its nominal radius is 1, as in struct model
+ * A file from a machine with the other byte order reads as the wrong version,
+ * and is refused.
+ *
+ * Entries with the same name in a row make a set: all the asteroids are
+ * "roid", and the logo is one "logo" per letter. The game needs a ship, a
+ * flame, a bullet, and at least one roid and one logo letter.
+ *
+ * I'm releasing this code under the WTFPL. You can do whatever you like with
+ * it, though I'd appreciate credit and thanks if you find it useful or fun.
+ * See LICENSE.txt for details.
+ *            -Joe McKenzie / Chupi
+ */
+
+#ifndef __VMODEL_H__
+#define __VMODEL_H__
+
+#include <stdint.h>
+#include <time.h>
+
+#define VMOD_MAGIC "VMOD"
+#define VMOD_VERSION 1
+#define VMOD_NAME_LEN 12
+
+struct vmodHeader {
+	char magic[4];	//VMOD_MAGIC, not terminated
+	uint32_t version;	//VMOD_VERSION
+	uint32_t nmodels;
+	uint32_t npoints;
+};
+
+struct vmodEntry {
+	char name[VMOD_NAME_LEN];	//what it is, terminated: ship, flame, bullet, roid or logo
+	uint32_t first;	//its first point
+	uint32_t n;	//number of points
+	uint32_t strokes;	//number of lines drawn between them
+	float radius;	//distance of the farthest point from the center
+};
+
+struct model;	//see asteroids_models.h
+
+//the shapes the game draws, compiled in or from a file
+struct modelSet {
+	const struct model *ship, *flame, *bullet;
+	const struct model *roids;
+	int nroids;
+	const struct model *logo;	//one per letter
+	int nletters;
+
+	//a file's models, pointing into what was read from it
+	struct model *loaded;
+	const void *data;
+
+	//the last version of the file vmodelReload saw, loaded or not
+	time_t mtime;
+	long ino, bytes;
+};
+
+/* vmodelBuiltin: use the models compiled in from asteroids_models.h         */
+extern void vmodelBuiltin(struct modelSet *ms);
+
+/* vmodelLoad: use the models in a file instead. If it can't be read or isn't
+ *   a good model file, says why on stderr and returns 0, and ms is unchanged. */
+extern int vmodelLoad(struct modelSet *ms, const char *filename);
+
+/* vmodelReload: load the file again if it's been replaced or changed since
+ *   ms was loaded from it. Returns 1 if it was, in which case any pointers to
+ *   the old models (the rotation cache's, say) need updating.               */
+extern int vmodelReload(struct modelSet *ms, const char *filename);
+
+/* vmodelFree: let go of a loaded file and go back to the compiled-in models */
+extern void vmodelFree(struct modelSet *ms);
+
+#endif